@@ -0,0 +1,91 @@
+/* cpbench.c
+
+   Compares copying a file through a user buffer with read() and
+   write() against copying it inside the kernel with sendfile().
+
+   Usage: cpbench [KB] */
+
+#include <cpu.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+
+static char buffer[1024];
+
+/* Creates a file named NAME, SIZE bytes long, and opens it.
+   Returns the new file descriptor, or -1 on failure. */
+static int
+create_open (const char *name, int size)
+{
+  if (!create (name, size))
+    {
+      printf ("%s: create failed\n", name);
+      return -1;
+    }
+  return open (name);
+}
+
+/* Copies SIZE bytes from IN_FD to a new file with read() and
+   write(), or with sendfile() if KERNEL is true, and prints how
+   long it took. */
+static bool
+copy (int in_fd, int size, bool kernel)
+{
+  static const char name[] = "cpbench.out";
+  int out_fd = create_open (name, size);
+  uint64_t start;
+  int copied = 0;
+
+  if (out_fd < 0)
+    return false;
+
+  seek (in_fd, 0);
+  start = rdtsc ();
+  if (kernel)
+    copied = sendfile (out_fd, in_fd, size);
+  else
+    for (;;)
+      {
+        int bytes_read = read (in_fd, buffer, sizeof buffer);
+        if (bytes_read == 0 || write (out_fd, buffer, bytes_read) != bytes_read)
+          break;
+        copied += bytes_read;
+      }
+  printf ("%s: %d bytes, %d kcycles\n", kernel ? "sendfile" : "read/write",
+          copied, (int) ((rdtsc () - start) / 1000));
+
+  close (out_fd);
+  remove (name);
+  return copied == size;
+}
+
+int
+main (int argc, char *argv[])
+{
+  static const char name[] = "cpbench.in";
+  int size = (argc > 1 ? atoi (argv[1]) : 1024) * 1024;
+  bool success;
+  int in_fd;
+  int i;
+
+  if (size <= 0)
+    {
+      printf ("usage: cpbench [KB]\n");
+      return EXIT_FAILURE;
+    }
+
+  in_fd = create_open (name, size);
+  if (in_fd < 0)
+    return EXIT_FAILURE;
+  memset (buffer, 'x', sizeof buffer);
+  for (i = 0; i < size; i += sizeof buffer)
+    write (in_fd, buffer, sizeof buffer);
+
+  success = copy (in_fd, size, false) && copy (in_fd, size, true);
+
+  close (in_fd);
+  remove (name);
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
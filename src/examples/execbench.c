@@ -0,0 +1,116 @@
+/* execbench.c
+
+   Measures how long it takes to run a program that exits at
+   once, the first time and on average over later runs, when the
+   kernel may reuse what it learned from the program's headers.
+   Then does the same runs with spawn() instead of exec().
+
+   Each set of runs uses a fresh copy of this program, so that
+   the kernel has not seen its headers before the first run.
+
+   Usage: execbench [ITERATIONS] */
+
+#include <cpu.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+
+/* Copies this program to a new file named NAME.  Returns true
+   if successful, false on failure. */
+static bool
+copy_self (const char *name)
+{
+  int in_fd, out_fd, size;
+  bool success;
+
+  in_fd = open ("execbench");
+  if (in_fd < 0)
+    return false;
+  size = filesize (in_fd);
+  remove (name);
+  if (!create (name, size))
+    {
+      close (in_fd);
+      return false;
+    }
+  out_fd = open (name);
+  success = out_fd >= 0 && sendfile (out_fd, in_fd, size) == size;
+  close (in_fd);
+  if (out_fd >= 0)
+    close (out_fd);
+  return success;
+}
+
+/* Runs "PROG child", with spawn() if USE_SPAWN is true or exec()
+   otherwise, and waits for it.  Returns the number of cycles
+   that took, or 0 on failure. */
+static uint64_t
+run_child (const char *prog, bool use_spawn)
+{
+  char cmd_line[32];
+  char *argv[3];
+  uint64_t start;
+  pid_t pid;
+
+  snprintf (cmd_line, sizeof cmd_line, "%s child", prog);
+  argv[0] = (char *) prog;
+  argv[1] = "child";
+  argv[2] = NULL;
+
+  start = rdtsc ();
+  pid = use_spawn ? spawn (argv, 0) : exec (cmd_line);
+  if (pid == PID_ERROR || wait (pid) != 0)
+    return 0;
+  return rdtsc () - start;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int iterations;
+  uint64_t first, rest;
+  int use_spawn;
+  int i;
+
+  if (argc > 1 && !strcmp (argv[1], "child"))
+    return EXIT_SUCCESS;
+
+  iterations = argc > 1 ? atoi (argv[1]) : 100;
+  if (iterations <= 1)
+    {
+      printf ("usage: execbench [ITERATIONS]\n");
+      return EXIT_FAILURE;
+    }
+
+  for (use_spawn = 0; use_spawn <= 1; use_spawn++)
+    {
+      const char *call = use_spawn ? "spawn" : "exec";
+      const char *prog = use_spawn ? "xbench-spawn" : "xbench-exec";
+
+      if (!copy_self (prog))
+        {
+          printf ("execbench: copying to %s failed\n", prog);
+          return EXIT_FAILURE;
+        }
+      first = run_child (prog, use_spawn);
+      rest = 0;
+      for (i = 1; i < iterations; i++)
+        {
+          uint64_t cycles = run_child (prog, use_spawn);
+          if (first == 0 || cycles == 0)
+            {
+              printf ("execbench: %s failed\n", call);
+              remove (prog);
+              return EXIT_FAILURE;
+            }
+          rest += cycles;
+        }
+      remove (prog);
+      printf ("first %s: %d kcycles\n", call, (int) (first / 1000));
+      printf ("later %ss: %d kcycles on average\n",
+              call, (int) (rest / (iterations - 1) / 1000));
+    }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+/* fdbench.c
+
+   Measures the cost of system calls that only look up a file
+   descriptor, and of opening and closing a file, with NFDS
+   descriptors open.
+
+   Usage: fdbench [NFDS] */
+
+#include <cpu.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+#define ITERATIONS 10000
+#define MAX_FDS 1024
+
+/* Prints the average cost of ITERATIONS calls that took CYCLES
+   in all. */
+static void
+report (const char *call, uint64_t cycles)
+{
+  printf ("%s: %d cycles per call\n", call, (int) (cycles / ITERATIONS));
+}
+
+int
+main (int argc, char *argv[])
+{
+  static const char name[] = "fdbench.tmp";
+  int nfds = argc > 1 ? atoi (argv[1]) : 256;
+  static int fds[MAX_FDS];
+  int opened;
+  uint64_t start;
+  int i;
+
+  if (nfds <= 0 || nfds > MAX_FDS)
+    {
+      printf ("usage: fdbench [NFDS]\n");
+      return EXIT_FAILURE;
+    }
+  if (!create (name, 0))
+    {
+      printf ("fdbench: create \"%s\" failed\n", name);
+      return EXIT_FAILURE;
+    }
+
+  for (opened = 0; opened < nfds; opened++)
+    {
+      fds[opened] = open (name);
+      if (fds[opened] < 0)
+        break;
+    }
+  printf ("%d of %d descriptors open\n", opened, nfds);
+  if (opened == 0)
+    return EXIT_FAILURE;
+
+  start = rdtsc ();
+  for (i = 0; i < ITERATIONS; i++)
+    filesize (fds[0]);
+  report ("filesize, lowest fd", rdtsc () - start);
+
+  start = rdtsc ();
+  for (i = 0; i < ITERATIONS; i++)
+    filesize (fds[opened - 1]);
+  report ("filesize, highest fd", rdtsc () - start);
+
+  start = rdtsc ();
+  for (i = 0; i < ITERATIONS; i++)
+    tell (fds[opened - 1]);
+  report ("tell, highest fd", rdtsc () - start);
+
+  /* Reuses the lowest slot each time. */
+  close (fds[0]);
+  start = rdtsc ();
+  for (i = 0; i < ITERATIONS; i++)
+    close (open (name));
+  report ("open + close", rdtsc () - start);
+
+  for (i = 1; i < opened; i++)
+    close (fds[i]);
+  remove (name);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+/* forkcow.c
+
+   Checks that fork() gives the child a private copy of the
+   parent's memory even though the two share pages until one of
+   them writes.  Parent and child each write to a data page, a
+   BSS page and the stack after the fork, and each checks
+   that it still sees only its own values.  The parent writes
+   right after fork() returns and the child only when it runs,
+   so whichever order they run in, some write has to copy a
+   shared page.
+
+   Needs the VM kernel, which implements fork(). */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+/* Values the pages hold before the fork, and the values the
+   parent and the child write afterward. */
+#define BEFORE 1
+#define PARENT 2
+#define CHILD 3
+
+static volatile int data_page[1024] = {BEFORE};
+static volatile int bss_page[1024];
+
+/* Sets the data and BSS pages and *STACK to VALUE. */
+static void
+write_pages (volatile int *stack, int value)
+{
+  data_page[0] = bss_page[0] = *stack = value;
+}
+
+/* Returns true if the data and BSS pages and *STACK hold
+   VALUE. */
+static bool
+check_pages (volatile int *stack, int value)
+{
+  return data_page[0] == value && bss_page[0] == value
+         && *stack == value;
+}
+
+int
+main (void)
+{
+  volatile int stack_value;
+  pid_t pid;
+
+  write_pages (&stack_value, BEFORE);
+  pid = fork ();
+  if (pid == PID_ERROR)
+    {
+      printf ("forkcow: fork failed\n");
+      return EXIT_FAILURE;
+    }
+
+  if (pid == 0)
+    {
+      /* Child: the parent may have written already, but we must
+         not see it. */
+      if (!check_pages (&stack_value, BEFORE))
+        return EXIT_FAILURE;
+      write_pages (&stack_value, CHILD);
+      return check_pages (&stack_value, CHILD) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+  /* Parent. */
+  write_pages (&stack_value, PARENT);
+  if (wait (pid) != EXIT_SUCCESS)
+    {
+      printf ("forkcow: child saw the parent's writes\n");
+      return EXIT_FAILURE;
+    }
+  if (!check_pages (&stack_value, PARENT))
+    {
+      printf ("forkcow: parent saw the child's writes\n");
+      return EXIT_FAILURE;
+    }
+  printf ("forkcow: ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+/* membench.c
+
+   Measures memcpy(), memmove() and memset() on blocks from 8
+   bytes to 64 kB, reporting how many bytes each moves per cycle.
+   memmove() is measured on overlapping blocks, which it has to
+   copy from the top down.
+
+   Usage: membench [KB-PER-SIZE] */
+
+#include <cpu.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+
+/* Largest block measured. */
+#define MAX_SIZE 65536
+
+/* Room for the largest block, plus slack for the overlapping
+   memmove(). */
+static char src[MAX_SIZE + 64];
+static char dst[MAX_SIZE];
+
+/* Prints BYTES per CYCLES as a decimal with two places. */
+static void
+report (size_t bytes, uint64_t cycles)
+{
+  unsigned hundredths = cycles ? bytes * 100ULL / cycles : 0;
+
+  printf (" %5u.%02u", hundredths / 100, hundredths % 100);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int kb = argc > 1 ? atoi (argv[1]) : 1024;
+  size_t size;
+
+  if (kb <= 0)
+    {
+      printf ("usage: membench [KB-PER-SIZE]\n");
+      return EXIT_FAILURE;
+    }
+
+  printf ("bytes per cycle\n");
+  printf ("%8s %8s %8s %8s\n", "size", "memcpy", "memmove", "memset");
+  for (size = 8; size <= MAX_SIZE; size *= 2)
+    {
+      /* Move about KB kilobytes at each size. */
+      size_t iterations = kb * 1024 / size;
+      size_t total;
+      uint64_t start;
+      size_t i;
+
+      if (iterations == 0)
+        iterations = 1;
+      total = iterations * size;
+
+      printf ("%8zu", size);
+
+      start = rdtsc ();
+      for (i = 0; i < iterations; i++)
+        memcpy (dst, src, size);
+      report (total, rdtsc () - start);
+
+      start = rdtsc ();
+      for (i = 0; i < iterations; i++)
+        memmove (src + 3, src, size);
+      report (total, rdtsc () - start);
+
+      start = rdtsc ();
+      for (i = 0; i < iterations; i++)
+        memset (dst, i, size);
+      report (total, rdtsc () - start);
+
+      printf ("\n");
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+/* nullcall.c
+
+   Measures the cost of a system call that does nothing, entered
+   with INT $0x30 and, if the kernel supports it, with SYSENTER.
+
+   Usage: nullcall [ITERATIONS] */
+
+#include <cpu.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include <syscall-nr.h>
+
+/* Makes the null system call through INT $0x30. */
+static inline int
+null_int (void)
+{
+  int retval;
+  asm volatile ("pushl %[number]; int $0x30; addl $4, %%esp"
+                : "=a" (retval)
+                : [number] "i" (SYS_SYSENTER)
+                : "memory");
+  return retval;
+}
+
+/* Makes the null system call through SYSENTER. */
+static inline void
+null_sysenter (void)
+{
+  asm volatile ("pushl %[number]; movl %%esp, %%ecx; movl $1f, %%edx; "
+                "sysenter; 1: addl $4, %%esp"
+                :
+                : [number] "i" (SYS_SYSENTER)
+                : "eax", "ecx", "edx", "memory");
+}
+
+/* Prints the average cost of ITERATIONS calls that took CYCLES
+   in all. */
+static void
+report (const char *path, uint64_t cycles, int iterations)
+{
+  printf ("%s: %d calls, %d cycles per call\n",
+          path, iterations, (int) (cycles / iterations));
+}
+
+int
+main (int argc, char *argv[])
+{
+  int iterations = argc > 1 ? atoi (argv[1]) : 10000;
+  bool fast;
+  uint64_t start;
+  int i;
+
+  if (iterations <= 0)
+    {
+      printf ("usage: nullcall [ITERATIONS]\n");
+      return EXIT_FAILURE;
+    }
+
+  fast = null_int ();
+
+  start = rdtsc ();
+  for (i = 0; i < iterations; i++)
+    null_int ();
+  report ("int $0x30", rdtsc () - start, iterations);
+
+  if (fast)
+    {
+      start = rdtsc ();
+      for (i = 0; i < iterations; i++)
+        null_sysenter ();
+      report ("sysenter", rdtsc () - start, iterations);
+    }
+  else
+    printf ("sysenter: not supported\n");
+
+  return EXIT_SUCCESS;
+}
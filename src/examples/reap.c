@@ -0,0 +1,73 @@
+/* reap.c
+
+   Starts NCHILDREN copies of itself at once and reaps them in
+   whatever order they finish, with waitany().  Each child exits
+   with its own index, after a delay that shrinks with the index,
+   so the last started tend to finish first.
+
+   Usage: reap [NCHILDREN] */
+
+#include <cpu.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+
+#define MAX_CHILDREN 64
+
+int
+main (int argc, char *argv[])
+{
+  static char arg[16];
+  char *child_argv[] = {"reap", "child", arg, NULL};
+  int nchildren;
+  int reaped, polls;
+  uint64_t start;
+  int i;
+
+  if (argc == 3 && !strcmp (argv[1], "child"))
+    {
+      volatile int spin;
+      int idx = atoi (argv[2]);
+      for (spin = 0; spin < (MAX_CHILDREN - idx) * 10000; spin++)
+        continue;
+      return idx;
+    }
+
+  nchildren = argc > 1 ? atoi (argv[1]) : 16;
+  if (nchildren <= 0 || nchildren > MAX_CHILDREN)
+    {
+      printf ("usage: reap [NCHILDREN], at most %d\n", MAX_CHILDREN);
+      return EXIT_FAILURE;
+    }
+
+  start = rdtsc ();
+  for (i = 0; i < nchildren; i++)
+    {
+      snprintf (arg, sizeof arg, "%d", i);
+      if (spawn (child_argv, 0) == PID_ERROR)
+        {
+          printf ("reap: spawn failed\n");
+          return EXIT_FAILURE;
+        }
+    }
+
+  /* Poll once, then block up to a second at a time. */
+  reaped = polls = 0;
+  for (;;)
+    {
+      int status;
+      pid_t pid = polls++ == 0 ? waitany (&status)
+                               : waitany_timeout (&status, 1000);
+      if (pid == PID_ERROR)
+        break;
+      if (pid == 0)
+        continue;
+      printf ("child %d exited with status %d\n", pid, status);
+      reaped++;
+    }
+  printf ("reaped %d of %d children in %d kcycles, %d calls\n",
+          reaped, nchildren, (int) ((rdtsc () - start) / 1000), polls);
+  return reaped == nchildren ? EXIT_SUCCESS : EXIT_FAILURE;
+}
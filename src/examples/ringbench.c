@@ -0,0 +1,99 @@
+/* ringbench.c
+
+   Compares creating files with one system call per operation
+   against batching the same calls through a system call ring.
+
+   The root directory only has room for a handful of files, so
+   each of the NFILES files is removed again right after it is
+   created: both paths make 2 * NFILES calls.
+
+   Usage: ringbench [NFILES] */
+
+#include <cpu.h>
+#include <ring.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include <syscall-nr.h>
+
+static struct ring ring;
+
+/* Queues system call OPCODE with argument ARG0, and ARG1 if it
+   takes two. */
+static void
+queue (int opcode, const void *arg0, unsigned arg1)
+{
+  struct ring_sqe *sqe = &ring.sq[ring.sq_tail % RING_ENTRIES];
+
+  sqe->opcode = opcode;
+  sqe->args[0] = (uint32_t) arg0;
+  sqe->args[1] = arg1;
+  sqe->user_data = ring.sq_tail;
+  ring.sq_tail++;
+}
+
+/* Submits the queued calls and checks their completions.
+   Returns the number of calls that failed. */
+static int
+submit (void)
+{
+  int failures = 0;
+
+  while (ring.sq_head != ring.sq_tail)
+    {
+      ring_enter ();
+      for (; ring.cq_head != ring.cq_tail; ring.cq_head++)
+        if (ring.cq[ring.cq_head % RING_ENTRIES].result != 1)
+          failures++;
+    }
+  return failures;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int nfiles = argc > 1 ? atoi (argv[1]) : 1000;
+  static const char name[] = "ringbench.tmp";
+  uint64_t start;
+  int failures;
+  int i;
+
+  if (nfiles <= 0)
+    {
+      printf ("usage: ringbench [NFILES]\n");
+      return EXIT_FAILURE;
+    }
+
+  /* One trap per call. */
+  failures = 0;
+  start = rdtsc ();
+  for (i = 0; i < nfiles; i++)
+    {
+      failures += !create (name, 0);
+      failures += !remove (name);
+    }
+  printf ("classic: %d files, %d cycles per file, %d failures\n",
+          nfiles, (int) ((rdtsc () - start) / nfiles), failures);
+
+  /* One trap per RING_ENTRIES calls. */
+  if (!ring_setup (&ring))
+    {
+      printf ("ring: not supported\n");
+      return EXIT_FAILURE;
+    }
+  failures = 0;
+  start = rdtsc ();
+  for (i = 0; i < nfiles; i++)
+    {
+      queue (SYS_CREATE, name, 0);
+      queue (SYS_REMOVE, name, 0);
+      if (ring.sq_tail - ring.sq_head == RING_ENTRIES)
+        failures += submit ();
+    }
+  failures += submit ();
+  printf ("ring: %d files, %d cycles per file, %d failures\n",
+          nfiles, (int) ((rdtsc () - start) / nfiles), failures);
+
+  return EXIT_SUCCESS;
+}
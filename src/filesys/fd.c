@@ -15,127 +15,118 @@
 
 #define IDX_TO_FD(I) ((I) + FD_MIN)
 #define FD_TO_IDX(F) ((F) - FD_MIN)
+#define FD_CNT (FD_MAX - FD_MIN + 1)
 
-struct _fd_node
-{
-    struct hash_elem elem;
-    struct file *file;
-    int fd;
-};
+static bool fd_grow(struct fd_node *fd_node, size_t size);
 
-void fd_clean (struct hash_elem *e, void *aux);
-static unsigned fd_hash_func(const struct hash_elem *e, void *aux UNUSED);
-static bool fd_less_func(const struct hash_elem *a,
-                         const struct hash_elem *b,
-                         void *aux UNUSED);
-
-static unsigned fd_hash_func (const struct hash_elem *e, void *aux UNUSED)
+/* Resizes the table to SIZE slots, which must be more than it
+ * has, clearing the new ones.
+ */
+static bool fd_grow(struct fd_node *fd_node, size_t size)
 {
-    const struct _fd_node *node = hash_entry(e, const struct _fd_node, elem);
-    return hash_int(node->fd);
-}
+    struct file **files;
 
-static bool fd_less_func (const struct hash_elem *a,
-                          const struct hash_elem *b,
-                          void *aux UNUSED)
-{
-    const struct _fd_node *node_a = hash_entry(a, const struct _fd_node, elem);
-    const struct _fd_node *node_b = hash_entry(b, const struct _fd_node, elem);
-    return node_a->fd < node_b->fd;
+    files = realloc(fd_node->files, size * sizeof *files);
+    if(!files)
+        return false;
+    memset(files + fd_node->size, 0,
+           (size - fd_node->size) * sizeof *files);
+    fd_node->files = files;
+    fd_node->size = size;
+    return true;
 }
 
 bool fd_init(struct fd_node *fd_node)
 {
-    fd_node->fd_bm = bitmap_create(FD_MAX);
-    if(!fd_node->fd_bm)
-        return false;
-    if(!hash_init(&fd_node->fd_hash, fd_hash_func, fd_less_func, NULL))
-        return false;
-    return true;
+    fd_node->files = NULL;
+    fd_node->size = 0;
+    fd_node->hint = 0;
+    return fd_grow(fd_node, FD_INIT_CNT);
 }
 
 void fd_destroy(struct fd_node *fd_node, fd_destructor *destruct)
 {
-    fd_node->fd_hash.aux = destruct;
+    size_t idx;
 
-    if(!fd_node->fd_bm)
+    if(!fd_node->files)
         return;
-    bitmap_destroy(fd_node->fd_bm);
-    hash_destroy(&fd_node->fd_hash, fd_clean);
-    fd_node->fd_hash.aux = NULL;
+    if(destruct)
+        for(idx = 0; idx < fd_node->size; idx++)
+            if(fd_node->files[idx])
+                destruct(fd_node->files[idx]);
+    free(fd_node->files);
+    fd_node->files = NULL;
+    fd_node->size = 0;
 }
 
 int fd_insert(struct fd_node *fd_node, struct file *file)
 {
-    struct _fd_node *node;
     size_t idx;
 
-    idx = bitmap_scan(fd_node->fd_bm, 0, 1, false);
-    if(idx == BITMAP_ERROR)
-        return FD_INVALID;
+    for(idx = fd_node->hint; idx < fd_node->size; idx++)
+        if(!fd_node->files[idx])
+            break;
 
-    node = malloc(sizeof (struct _fd_node));
-    if(!node)
-        return FD_INVALID;
-
-    node->fd = IDX_TO_FD(idx);
-    node->file = file;
-
-    if(hash_insert(&fd_node->fd_hash, &node->elem) != NULL)
+    if(idx == fd_node->size)
     {
-        free(node);
-        return FD_INVALID;
+        size_t size = fd_node->size * 2;
+        if(size > FD_CNT)
+            size = FD_CNT;
+        if(idx == size || !fd_grow(fd_node, size))
+            return FD_INVALID;
     }
-    bitmap_set(fd_node->fd_bm, idx, true);
-    return node->fd;
+
+    fd_node->files[idx] = file;
+    fd_node->hint = idx + 1;
+    return IDX_TO_FD(idx);
 }
 
 struct file* fd_remove(struct fd_node *fd_node, int fd)
 {
-    struct _fd_node node;
-    struct hash_elem *ret;
     struct file *file;
+    size_t idx;
 
-    if(fd < FD_MIN || fd > FD_MAX)
-        return false;
-
-    if(!bitmap_test(fd_node->fd_bm, FD_TO_IDX(fd)))
+    if(fd < FD_MIN)
         return NULL;
-
-    node.fd = fd;
-    bitmap_set(fd_node->fd_bm, FD_TO_IDX(fd), false);
-    ret = hash_delete(&fd_node->fd_hash, &node.elem);
-    if(ret == NULL)
+    idx = FD_TO_IDX(fd);
+    if(idx >= fd_node->size)
         return NULL;
-    file = hash_entry(ret, struct _fd_node, elem)->file;
-    free(ret);
+
+    file = fd_node->files[idx];
+    fd_node->files[idx] = NULL;
+    if(file && idx < fd_node->hint)
+        fd_node->hint = idx;
     return file;
 }
 
 struct file* fd_search(struct fd_node *fd_node, int fd)
 {
-    struct _fd_node node;
-    struct hash_elem *ret;
-
-    if(fd < FD_MIN || fd > FD_MAX)
-        return false;
-
-    if(!bitmap_test(fd_node->fd_bm, FD_TO_IDX(fd)))
-        return NULL;
+    size_t idx = FD_TO_IDX(fd);
 
-    node.fd = fd;
-    ret = hash_find(&fd_node->fd_hash, &node.elem);
-    if(ret == NULL)
+    if(fd < FD_MIN || idx >= fd_node->size)
         return NULL;
-    return hash_entry(ret, struct _fd_node, elem)->file;
+    return fd_node->files[idx];
 }
 
-void fd_clean (struct hash_elem *e, void *aux)
+/* Fills the empty table DST with the descriptors of SRC, each
+ * referring to the file returned by COPY for the file in SRC.
+ * Returns false if COPY or a memory allocation fails; the
+ * descriptors copied so far are left in DST for fd_destroy().
+ */
+bool fd_copy(struct fd_node *dst, struct fd_node *src, fd_copier *copy)
 {
-    if(aux)
-    {
-        fd_destructor *dest = (fd_destructor*)aux;
-        dest(hash_entry(e, struct _fd_node, elem)->file);
-    }
-    free(e);
+    size_t idx;
+
+    if(dst->size < src->size && !fd_grow(dst, src->size))
+        return false;
+
+    for(idx = 0; idx < src->size; idx++)
+        if(src->files[idx])
+        {
+            dst->files[idx] = copy(src->files[idx]);
+            if(!dst->files[idx])
+                return false;
+        }
+    dst->hint = src->hint;
+    return true;
 }
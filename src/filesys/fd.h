@@ -8,19 +8,30 @@
 #ifndef PINTOS_SRC_FILESYS_FD_H_
 #define PINTOS_SRC_FILESYS_FD_H_
 
-#include <bitmap.h>
-#include <hash.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 #define FD_INVALID      -1
 #define FD_MIN          2
-#define FD_MAX          128
+#define FD_INIT_CNT     16
+#define FD_MAX          1024
+
+struct file;
 
 typedef void fd_destructor(struct file *file);
+typedef struct file* fd_copier(struct file *file);
 
+/* Descriptor table.  FILES[I] is the file open as descriptor
+ * I + FD_MIN, or NULL.  The array starts with FD_INIT_CNT slots
+ * and doubles when it fills up, to at most FD_MAX - FD_MIN + 1.
+ * Every slot below HINT is in use, so the lowest free descriptor
+ * is found without looking at them.
+ */
 struct fd_node
 {
-    struct bitmap *fd_bm;
-    struct hash fd_hash;
+    struct file **files;
+    size_t size;
+    size_t hint;
 };
 
 bool fd_init(struct fd_node *fd_node);
@@ -28,5 +39,6 @@ void fd_destroy(struct fd_node *fd_node, fd_destructor *destruct);
 int fd_insert(struct fd_node *fd_node, struct file *file);
 struct file* fd_remove(struct fd_node *fd_node, int fd);
 struct file* fd_search(struct fd_node *fd_node, int fd);
+bool fd_copy(struct fd_node *dst, struct fd_node *src, fd_copier *copy);
 
 #endif /* PINTOS_SRC_FILESYS_FD_H_ */
@@ -2,10 +2,12 @@
 #include <list.h>
 #include <debug.h>
 #include <round.h>
+#include <stdio.h>
 #include <string.h>
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -28,6 +30,14 @@ bytes_to_sectors (off_t size)
   return DIV_ROUND_UP (size, BLOCK_SECTOR_SIZE);
 }
 
+/* Bytes moved between the disk and callers' buffers.  Whole,
+   aligned sectors go straight between the block device and the
+   caller's buffer, which for a system call is the user's own
+   pages; anything else passes through a bounce buffer and costs
+   a memcpy. */
+static long long direct_bytes;          /* Without a copy. */
+static long long copied_bytes;          /* Through a bounce buffer. */
+
 /* In-memory inode. */
 struct inode 
   {
@@ -36,6 +46,7 @@ struct inode
     int open_cnt;                       /* Number of openers. */
     bool removed;                       /* True if deleted, false otherwise. */
     int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+    unsigned version;                   /* Incremented by each write. */
     struct inode_disk data;             /* Inode content. */
   };
 
@@ -57,11 +68,15 @@ byte_to_sector (const struct inode *inode, off_t pos)
    returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Cache of `struct inode's. */
+static struct slab_cache inode_cache;
+
 /* Initializes the inode module. */
 void
 inode_init (void) 
 {
   list_init (&open_inodes);
+  slab_cache_init (&inode_cache, "inode", sizeof (struct inode), NULL);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -127,7 +142,7 @@ inode_open (block_sector_t sector)
     }
 
   /* Allocate memory. */
-  inode = malloc (sizeof *inode);
+  inode = slab_alloc (&inode_cache);
   if (inode == NULL)
     return NULL;
 
@@ -136,6 +151,7 @@ inode_open (block_sector_t sector)
   inode->sector = sector;
   inode->open_cnt = 1;
   inode->deny_write_cnt = 0;
+  inode->version = 0;
   inode->removed = false;
   block_read (fs_device, inode->sector, &inode->data);
   return inode;
@@ -181,7 +197,7 @@ inode_close (struct inode *inode)
                             bytes_to_sectors (inode->data.length)); 
         }
 
-      free (inode); 
+      slab_free (&inode_cache, inode); 
     }
 }
 
@@ -194,6 +210,14 @@ inode_remove (struct inode *inode)
   inode->removed = true;
 }
 
+/* Returns true if INODE has been marked for deletion by
+   inode_remove(), false otherwise. */
+bool
+inode_is_removed (const struct inode *inode)
+{
+  return inode->removed;
+}
+
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
    Returns the number of bytes actually read, which may be less
    than SIZE if an error occurs or end of file is reached. */
@@ -224,6 +248,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
         {
           /* Read full sector directly into caller's buffer. */
           block_read (fs_device, sector_idx, buffer + bytes_read);
+          direct_bytes += BLOCK_SECTOR_SIZE;
         }
       else 
         {
@@ -237,6 +262,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
             }
           block_read (fs_device, sector_idx, bounce);
           memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
+          copied_bytes += chunk_size;
         }
       
       /* Advance. */
@@ -285,6 +311,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
         {
           /* Write full sector directly to disk. */
           block_write (fs_device, sector_idx, buffer + bytes_written);
+          direct_bytes += BLOCK_SECTOR_SIZE;
         }
       else 
         {
@@ -304,6 +331,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
           else
             memset (bounce, 0, BLOCK_SECTOR_SIZE);
           memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
+          copied_bytes += chunk_size;
           block_write (fs_device, sector_idx, bounce);
         }
 
@@ -313,6 +341,8 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
       bytes_written += chunk_size;
     }
   free (bounce);
+  if (bytes_written > 0)
+    inode->version++;
 
   return bytes_written;
 }
@@ -343,3 +373,19 @@ inode_length (const struct inode *inode)
 {
   return inode->data.length;
 }
+
+/* Returns a number that changes whenever INODE's data is
+   written, for as long as INODE stays open. */
+unsigned
+inode_get_version (const struct inode *inode)
+{
+  return inode->version;
+}
+
+/* Prints statistics about inode data transfers. */
+void
+inode_print_stats (void)
+{
+  printf ("Inodes: %lld bytes transferred directly, %lld bytes copied\n",
+          direct_bytes, copied_bytes);
+}
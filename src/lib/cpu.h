@@ -0,0 +1,18 @@
+#ifndef __LIB_CPU_H
+#define __LIB_CPU_H
+
+#include <stdint.h>
+
+/* Returns the processor's time-stamp counter, which counts clock
+   cycles since reset.  Usable by both the kernel and user
+   programs. */
+static inline uint64_t
+rdtsc (void)
+{
+  /* See [IA32-v2b] "RDTSC". */
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+#endif /* lib/cpu.h */
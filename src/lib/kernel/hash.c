@@ -18,6 +18,12 @@ static struct hash_elem *find_elem (struct hash *, struct list *,
 static void insert_elem (struct hash *, struct list *, struct hash_elem *);
 static void remove_elem (struct hash *, struct hash_elem *);
 static void rehash (struct hash *);
+static void move_buckets (struct hash *, size_t cnt);
+static struct list *next_bucket (struct hash *, struct list *);
+
+/* Old buckets moved per insertion or deletion while a table made
+   with hash_init_incremental() is being resized. */
+#define MOVE_BUCKETS 4
 
 /* Initializes hash table H to compute hash values using HASH and
    compare hash elements using LESS, given auxiliary data AUX. */
@@ -28,6 +34,10 @@ hash_init (struct hash *h,
   h->elem_cnt = 0;
   h->bucket_cnt = 4;
   h->buckets = malloc (sizeof *h->buckets * h->bucket_cnt);
+  h->old_buckets = NULL;
+  h->old_bucket_cnt = 0;
+  h->moved_cnt = 0;
+  h->incremental = false;
   h->hash = hash;
   h->less = less;
   h->aux = aux;
@@ -41,6 +51,18 @@ hash_init (struct hash *h,
     return false;
 }
 
+/* Initializes hash table H like hash_init(), except that it
+   resizes itself a few buckets at a time.  See hash.h. */
+bool
+hash_init_incremental (struct hash *h,
+                       hash_hash_func *hash, hash_less_func *less, void *aux) 
+{
+  if (!hash_init (h, hash, less, aux))
+    return false;
+  h->incremental = true;
+  return true;
+}
+
 /* Removes all the elements from H.
    
    If DESTRUCTOR is non-null, then it is called for each element
@@ -53,12 +75,11 @@ hash_init (struct hash *h,
 void
 hash_clear (struct hash *h, hash_action_func *destructor) 
 {
-  size_t i;
+  struct list *bucket;
 
-  for (i = 0; i < h->bucket_cnt; i++) 
+  for (bucket = next_bucket (h, NULL); bucket != NULL;
+       bucket = next_bucket (h, bucket)) 
     {
-      struct list *bucket = &h->buckets[i];
-
       if (destructor != NULL) 
         while (!list_empty (bucket)) 
           {
@@ -70,6 +91,9 @@ hash_clear (struct hash *h, hash_action_func *destructor)
       list_init (bucket); 
     }    
 
+  /* Nothing is left to move. */
+  free (h->old_buckets);
+  h->old_buckets = NULL;
   h->elem_cnt = 0;
 }
 
@@ -88,6 +112,7 @@ hash_destroy (struct hash *h, hash_action_func *destructor)
 {
   if (destructor != NULL)
     hash_clear (h, destructor);
+  free (h->old_buckets);
   free (h->buckets);
 }
 
@@ -162,13 +187,13 @@ hash_delete (struct hash *h, struct hash_elem *e)
 void
 hash_apply (struct hash *h, hash_action_func *action) 
 {
-  size_t i;
+  struct list *bucket;
   
   ASSERT (action != NULL);
 
-  for (i = 0; i < h->bucket_cnt; i++) 
+  for (bucket = next_bucket (h, NULL); bucket != NULL;
+       bucket = next_bucket (h, bucket)) 
     {
-      struct list *bucket = &h->buckets[i];
       struct list_elem *elem, *next;
 
       for (elem = list_begin (bucket); elem != list_end (bucket); elem = next) 
@@ -203,7 +228,7 @@ hash_first (struct hash_iterator *i, struct hash *h)
   ASSERT (h != NULL);
 
   i->hash = h;
-  i->bucket = i->hash->buckets;
+  i->bucket = next_bucket (h, NULL);
   i->elem = list_elem_to_hash_elem (list_head (i->bucket));
 }
 
@@ -223,7 +248,8 @@ hash_next (struct hash_iterator *i)
   i->elem = list_elem_to_hash_elem (list_next (&i->elem->list_elem));
   while (i->elem == list_elem_to_hash_elem (list_end (i->bucket)))
     {
-      if (++i->bucket >= i->hash->buckets + i->hash->bucket_cnt)
+      i->bucket = next_bucket (i->hash, i->bucket);
+      if (i->bucket == NULL)
         {
           i->elem = NULL;
           break;
@@ -301,12 +327,37 @@ hash_int (int i)
   return hash_bytes (&i, sizeof i);
 }
 
-/* Returns the bucket in H that E belongs in. */
+/* Returns the bucket in H that E belongs in.  While H is being
+   resized, that is E's old bucket unless it has already been
+   moved. */
 static struct list *
 find_bucket (struct hash *h, struct hash_elem *e) 
 {
-  size_t bucket_idx = h->hash (e, h->aux) & (h->bucket_cnt - 1);
-  return &h->buckets[bucket_idx];
+  unsigned hash = h->hash (e, h->aux);
+
+  if (h->old_buckets != NULL) 
+    {
+      size_t old_idx = hash & (h->old_bucket_cnt - 1);
+      if (old_idx >= h->moved_cnt)
+        return &h->old_buckets[old_idx];
+    }
+  return &h->buckets[hash & (h->bucket_cnt - 1)];
+}
+
+/* Returns the bucket in H after BUCKET, or the first one if
+   BUCKET is null, or a null pointer after the last one.  The
+   old buckets, if any, come before the current ones. */
+static struct list *
+next_bucket (struct hash *h, struct list *bucket) 
+{
+  struct list *old_end = h->old_buckets + h->old_bucket_cnt;
+
+  if (bucket == NULL)
+    return h->old_buckets != NULL ? h->old_buckets : h->buckets;
+  if (h->old_buckets != NULL
+      && bucket >= h->old_buckets && bucket < old_end)
+    return ++bucket < old_end ? bucket : h->buckets;
+  return ++bucket < h->buckets + h->bucket_cnt ? bucket : NULL;
 }
 
 /* Searches BUCKET in H for a hash element equal to E.  Returns
@@ -347,19 +398,24 @@ is_power_of_2 (size_t x)
 /* Changes the number of buckets in hash table H to match the
    ideal.  This function can fail because of an out-of-memory
    condition, but that'll just make hash accesses less efficient;
-   we can still continue. */
+   we can still continue.
+
+   An incremental table that is already being resized only moves
+   the next few old buckets. */
 static void
 rehash (struct hash *h) 
 {
-  size_t old_bucket_cnt, new_bucket_cnt;
-  struct list *new_buckets, *old_buckets;
+  size_t new_bucket_cnt;
+  struct list *new_buckets;
   size_t i;
 
   ASSERT (h != NULL);
 
-  /* Save old bucket info for later use. */
-  old_buckets = h->buckets;
-  old_bucket_cnt = h->bucket_cnt;
+  if (h->old_buckets != NULL) 
+    {
+      move_buckets (h, MOVE_BUCKETS);
+      return;
+    }
 
   /* Calculate the number of buckets to use now.
      We want one bucket for about every BEST_ELEMS_PER_BUCKET.
@@ -372,7 +428,7 @@ rehash (struct hash *h)
     new_bucket_cnt = turn_off_least_1bit (new_bucket_cnt);
 
   /* Don't do anything if the bucket count wouldn't change. */
-  if (new_bucket_cnt == old_bucket_cnt)
+  if (new_bucket_cnt == h->bucket_cnt)
     return;
 
   /* Allocate new buckets and initialize them as empty. */
@@ -387,29 +443,42 @@ rehash (struct hash *h)
   for (i = 0; i < new_bucket_cnt; i++) 
     list_init (&new_buckets[i]);
 
-  /* Install new bucket info. */
+  /* Install new bucket info, keeping the old buckets until their
+     elements have been moved. */
+  h->old_buckets = h->buckets;
+  h->old_bucket_cnt = h->bucket_cnt;
+  h->moved_cnt = 0;
   h->buckets = new_buckets;
   h->bucket_cnt = new_bucket_cnt;
 
-  /* Move each old element into the appropriate new bucket. */
-  for (i = 0; i < old_bucket_cnt; i++) 
+  move_buckets (h, h->incremental ? MOVE_BUCKETS : h->old_bucket_cnt);
+}
+
+/* Moves the elements of up to CNT more of H's old buckets into
+   the current ones, and frees the old buckets once all of them
+   have been moved. */
+static void
+move_buckets (struct hash *h, size_t cnt) 
+{
+  ASSERT (h->old_buckets != NULL);
+
+  for (; cnt > 0 && h->moved_cnt < h->old_bucket_cnt; cnt--) 
     {
-      struct list *old_bucket;
-      struct list_elem *elem, *next;
+      struct list *old_bucket = &h->old_buckets[h->moved_cnt++];
 
-      old_bucket = &old_buckets[i];
-      for (elem = list_begin (old_bucket);
-           elem != list_end (old_bucket); elem = next) 
+      while (!list_empty (old_bucket)) 
         {
-          struct list *new_bucket
-            = find_bucket (h, list_elem_to_hash_elem (elem));
-          next = list_next (elem);
-          list_remove (elem);
-          list_push_front (new_bucket, elem);
+          struct list_elem *elem = list_pop_front (old_bucket);
+          list_push_front (find_bucket (h, list_elem_to_hash_elem (elem)),
+                           elem);
         }
     }
 
-  free (old_buckets);
+  if (h->moved_cnt == h->old_bucket_cnt) 
+    {
+      free (h->old_buckets);
+      h->old_buckets = NULL;
+    }
 }
 
 /* Inserts E into BUCKET (in hash table H). */
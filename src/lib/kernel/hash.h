@@ -18,7 +18,17 @@
    conversion from a struct hash_elem back to a structure object
    that contains it.  This is the same technique used in the
    linked list implementation.  Refer to lib/kernel/list.h for a
-   detailed explanation. */
+   detailed explanation.
+
+   Normally, when an insertion or deletion changes the ideal
+   number of buckets, the table moves every element into a new
+   bucket array on the spot.  A table set up with
+   hash_init_incremental() instead moves the elements of only a
+   few old buckets per insertion or deletion, so that no single
+   operation takes time proportional to the size of the table.
+   Until it is done, each element is in whichever array its old
+   bucket says: the old one if that bucket has not been moved
+   yet, otherwise the new one. */
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -61,6 +71,10 @@ struct hash
     size_t elem_cnt;            /* Number of elements in table. */
     size_t bucket_cnt;          /* Number of buckets, a power of 2. */
     struct list *buckets;       /* Array of `bucket_cnt' lists. */
+    struct list *old_buckets;   /* Buckets being moved from, or null. */
+    size_t old_bucket_cnt;      /* Number of old buckets. */
+    size_t moved_cnt;           /* Old buckets already moved. */
+    bool incremental;           /* Move a few buckets at a time? */
     hash_hash_func *hash;       /* Hash function. */
     hash_less_func *less;       /* Comparison function. */
     void *aux;                  /* Auxiliary data for `hash' and `less'. */
@@ -76,6 +90,8 @@ struct hash_iterator
 
 /* Basic life cycle. */
 bool hash_init (struct hash *, hash_hash_func *, hash_less_func *, void *aux);
+bool hash_init_incremental (struct hash *, hash_hash_func *,
+                            hash_less_func *, void *aux);
 void hash_clear (struct hash *, hash_action_func *);
 void hash_destroy (struct hash *, hash_action_func *);
 
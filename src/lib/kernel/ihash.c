@@ -0,0 +1,286 @@
+/* Hash table keyed by integers, with open addressing.
+
+   See ihash.h for basic information. */
+
+#include "ihash.h"
+#include "../debug.h"
+#include "threads/malloc.h"
+
+/* Fewest slots a table has. */
+#define MIN_SLOTS 8
+
+static struct ihash_slot *home_slot (struct ihash *, unsigned key);
+static struct ihash_slot *find_slot (struct ihash *, unsigned key);
+static struct ihash_slot *next_slot (struct ihash *, struct ihash_slot *);
+static bool resize (struct ihash *, size_t slot_cnt);
+
+/* Initializes hash table H, with AUX as auxiliary data for
+   actions applied to it.  Returns false if memory is not
+   available. */
+bool
+ihash_init (struct ihash *h, void *aux)
+{
+  h->elem_cnt = 0;
+  h->slot_cnt = 0;
+  h->slots = NULL;
+  h->aux = aux;
+  return resize (h, MIN_SLOTS);
+}
+
+/* Removes all the entries from H.
+
+   If DESTRUCTOR is non-null, then it is called for each entry's
+   slot.  DESTRUCTOR may, if appropriate, deallocate the entry's
+   value.  However, modifying hash table H while ihash_clear() is
+   running, using any of the functions ihash_clear(),
+   ihash_destroy(), ihash_insert(), or ihash_delete(), yields
+   undefined behavior, whether done in DESTRUCTOR or
+   elsewhere. */
+void
+ihash_clear (struct ihash *h, ihash_action_func *destructor)
+{
+  size_t i;
+
+  for (i = 0; i < h->slot_cnt; i++)
+    {
+      struct ihash_slot *s = &h->slots[i];
+      if (s->value != NULL)
+        {
+          if (destructor != NULL)
+            destructor (s, h->aux);
+          s->value = NULL;
+        }
+    }
+  h->elem_cnt = 0;
+}
+
+/* Destroys hash table H, first calling DESTRUCTOR, if non-null,
+   for each entry as in ihash_clear(). */
+void
+ihash_destroy (struct ihash *h, ihash_action_func *destructor)
+{
+  if (destructor != NULL)
+    ihash_clear (h, destructor);
+  free (h->slots);
+}
+
+/* Inserts VALUE, which must be non-null, into H under KEY, which
+   must not already be in H.  Returns false if H was full and
+   could not grow. */
+bool
+ihash_insert (struct ihash *h, unsigned key, void *value)
+{
+  struct ihash_slot *s;
+
+  ASSERT (value != NULL);
+
+  /* Grow at 3/4 full.  If that fails, carry on until only one
+     slot is left empty, since lookups stop at an empty slot. */
+  if ((h->elem_cnt + 1) * 4 > h->slot_cnt * 3
+      && !resize (h, h->slot_cnt * 2)
+      && h->elem_cnt + 1 >= h->slot_cnt)
+    return false;
+
+  s = find_slot (h, key);
+  ASSERT (s->value == NULL);
+  s->key = key;
+  s->value = value;
+  h->elem_cnt++;
+  return true;
+}
+
+/* Returns the value stored under KEY in H, or a null pointer if
+   there is none. */
+void *
+ihash_find (struct ihash *h, unsigned key)
+{
+  return find_slot (h, key)->value;
+}
+
+/* Removes KEY from H and returns the value stored under it, or
+   returns a null pointer if KEY is not in H. */
+void *
+ihash_delete (struct ihash *h, unsigned key)
+{
+  struct ihash_slot *gap = find_slot (h, key);
+  struct ihash_slot *s;
+  void *value = gap->value;
+
+  if (value == NULL)
+    return NULL;
+
+  /* Shift back each following entry that may be moved into the
+     gap without coming before its home slot, until an empty
+     slot ends the run. */
+  for (s = next_slot (h, gap); s->value != NULL; s = next_slot (h, s))
+    {
+      size_t mask = h->slot_cnt - 1;
+      size_t home = home_slot (h, s->key) - h->slots;
+      size_t at = s - h->slots;
+      size_t from_gap = (at - (gap - h->slots)) & mask;
+
+      if (((at - home) & mask) >= from_gap)
+        {
+          *gap = *s;
+          gap = s;
+        }
+    }
+  gap->value = NULL;
+  h->elem_cnt--;
+
+  /* Shrink at 1/8 full.  Failure is harmless. */
+  if (h->slot_cnt > MIN_SLOTS && h->elem_cnt * 8 < h->slot_cnt)
+    resize (h, h->slot_cnt / 2);
+
+  return value;
+}
+
+/* Calls ACTION for each entry's slot in hash table H in
+   arbitrary order, with H's auxiliary data.  Modifying hash
+   table H while ihash_apply() is running, using any of the
+   functions ihash_clear(), ihash_destroy(), ihash_insert(), or
+   ihash_delete(), yields undefined behavior, whether done from
+   ACTION or elsewhere. */
+void
+ihash_apply (struct ihash *h, ihash_action_func *action)
+{
+  size_t i;
+
+  ASSERT (action != NULL);
+
+  for (i = 0; i < h->slot_cnt; i++)
+    if (h->slots[i].value != NULL)
+      action (&h->slots[i], h->aux);
+}
+
+/* Initializes I for iterating hash table H.
+
+   Iteration idiom:
+
+      struct ihash_iterator i;
+
+      ihash_first (&i, h);
+      while (ihash_next (&i))
+        {
+          struct ihash_slot *s = ihash_cur (&i);
+          ...do something with s->key and s->value...
+        }
+
+   Modifying hash table H during iteration, using any of the
+   functions ihash_clear(), ihash_destroy(), ihash_insert(), or
+   ihash_delete(), invalidates all iterators. */
+void
+ihash_first (struct ihash_iterator *i, struct ihash *h)
+{
+  ASSERT (i != NULL);
+  ASSERT (h != NULL);
+
+  i->hash = h;
+  i->slot = h->slots - 1;
+}
+
+/* Advances I to the next entry in the hash table and returns its
+   slot.  Returns a null pointer if no entries are left.  Entries
+   are returned in arbitrary order. */
+struct ihash_slot *
+ihash_next (struct ihash_iterator *i)
+{
+  struct ihash_slot *end;
+
+  ASSERT (i != NULL);
+
+  end = i->hash->slots + i->hash->slot_cnt;
+  if (i->slot == NULL)
+    return NULL;
+  while (++i->slot < end)
+    if (i->slot->value != NULL)
+      return i->slot;
+  i->slot = NULL;
+  return NULL;
+}
+
+/* Returns the current entry's slot in the hash table iteration,
+   or a null pointer at the end of the table.  Undefined behavior
+   after calling ihash_first() but before ihash_next(). */
+struct ihash_slot *
+ihash_cur (struct ihash_iterator *i)
+{
+  return i->slot;
+}
+
+/* Returns the number of entries in H. */
+size_t
+ihash_size (struct ihash *h)
+{
+  return h->elem_cnt;
+}
+
+/* Returns true if H contains no entries, false otherwise. */
+bool
+ihash_empty (struct ihash *h)
+{
+  return h->elem_cnt == 0;
+}
+
+/* Returns the slot where a lookup for KEY in H starts.  The key
+   is scrambled by Fibonacci hashing, so that runs of small
+   consecutive keys spread over the table, and the top bits of
+   the product pick the slot. */
+static struct ihash_slot *
+home_slot (struct ihash *h, unsigned key)
+{
+  return &h->slots[(key * 0x9e3779b1u) >> h->shift];
+}
+
+/* Returns the slot after S in H, wrapping around at the end. */
+static struct ihash_slot *
+next_slot (struct ihash *h, struct ihash_slot *s)
+{
+  return ++s < h->slots + h->slot_cnt ? s : h->slots;
+}
+
+/* Returns the slot in H that holds KEY, or the empty slot where
+   KEY would go if it is not in H. */
+static struct ihash_slot *
+find_slot (struct ihash *h, unsigned key)
+{
+  struct ihash_slot *s;
+
+  for (s = home_slot (h, key); s->value != NULL; s = next_slot (h, s))
+    if (s->key == key)
+      break;
+  return s;
+}
+
+/* Changes H to have SLOT_CNT slots, which must be a power of 2
+   with room for all of H's entries, and moves the entries into
+   them.  Returns false, leaving H unchanged, if memory is not
+   available. */
+static bool
+resize (struct ihash *h, size_t slot_cnt)
+{
+  struct ihash_slot *old_slots = h->slots;
+  size_t old_cnt = h->slot_cnt;
+  unsigned shift;
+  size_t i;
+
+  ASSERT ((slot_cnt & (slot_cnt - 1)) == 0);
+  ASSERT (h->elem_cnt < slot_cnt);
+
+  h->slots = calloc (slot_cnt, sizeof *h->slots);
+  if (h->slots == NULL)
+    {
+      h->slots = old_slots;
+      return false;
+    }
+  for (shift = 32; (1u << (32 - shift)) < slot_cnt; shift--)
+    continue;
+  h->slot_cnt = slot_cnt;
+  h->shift = shift;
+
+  for (i = 0; i < old_cnt; i++)
+    if (old_slots[i].value != NULL)
+      *find_slot (h, old_slots[i].key) = old_slots[i];
+  free (old_slots);
+  return true;
+}
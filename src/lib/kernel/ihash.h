@@ -0,0 +1,69 @@
+#ifndef __LIB_KERNEL_IHASH_H
+#define __LIB_KERNEL_IHASH_H
+
+/* Hash table keyed by integers, with open addressing.
+
+   This is meant for tables whose keys are small integers, such
+   as thread ids or sector numbers.  Unlike the chained table in
+   hash.h, it stores each key and a pointer to its value inline
+   in an array of slots, so a lookup hashes the key and scans
+   forward from there through adjacent slots instead of chasing
+   list pointers.  Deletion shifts later entries back into the
+   gap, so there are no tombstones and lookups stay short.
+
+   Values must be non-null: a null value marks an empty slot.
+   The table grows when it is 3/4 full and shrinks when it is
+   1/8 full.  As with hash.h, modifying a table while iterating
+   over it invalidates the iterator. */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* A key and its value. */
+struct ihash_slot
+  {
+    unsigned key;               /* Key. */
+    void *value;                /* Value, or null if the slot is empty. */
+  };
+
+/* Performs some operation on slot S, given auxiliary data AUX. */
+typedef void ihash_action_func (struct ihash_slot *s, void *aux);
+
+/* Hash table. */
+struct ihash
+  {
+    size_t elem_cnt;            /* Number of entries in table. */
+    size_t slot_cnt;            /* Number of slots, a power of 2. */
+    unsigned shift;             /* 32 - log2(slot_cnt). */
+    struct ihash_slot *slots;   /* Array of `slot_cnt' slots. */
+    void *aux;                  /* Auxiliary data for actions. */
+  };
+
+/* A hash table iterator. */
+struct ihash_iterator
+  {
+    struct ihash *hash;         /* The hash table. */
+    struct ihash_slot *slot;    /* Current slot. */
+  };
+
+/* Basic life cycle. */
+bool ihash_init (struct ihash *, void *aux);
+void ihash_clear (struct ihash *, ihash_action_func *);
+void ihash_destroy (struct ihash *, ihash_action_func *);
+
+/* Search, insertion, deletion. */
+bool ihash_insert (struct ihash *, unsigned key, void *value);
+void *ihash_find (struct ihash *, unsigned key);
+void *ihash_delete (struct ihash *, unsigned key);
+
+/* Iteration. */
+void ihash_apply (struct ihash *, ihash_action_func *);
+void ihash_first (struct ihash_iterator *, struct ihash *);
+struct ihash_slot *ihash_next (struct ihash_iterator *);
+struct ihash_slot *ihash_cur (struct ihash_iterator *);
+
+/* Information. */
+size_t ihash_size (struct ihash *);
+bool ihash_empty (struct ihash *);
+
+#endif /* lib/kernel/ihash.h */
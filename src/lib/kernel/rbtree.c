@@ -0,0 +1,478 @@
+/* Red-black tree.
+
+   See rbtree.h for basic information.
+
+   The tree keeps these invariants, which bound its height by
+   2 lg(n + 1):
+
+     1. The root is black.
+
+     2. A red element has no red child.
+
+     3. Every path from an element down to a null child passes
+        through the same number of black elements.
+
+   Insertion adds a red leaf, which can only break invariant 2,
+   and removal of a black element breaks invariant 3; the fixup
+   functions restore them with O(1) rotations and O(log n)
+   recolorings, following chapter 13 of Cormen et al.,
+   "Introduction to Algorithms".  Null children stand in for the
+   black leaves of the textbook version, so rb_erase() tracks the
+   parent of the element it fixes up. */
+
+#include "rbtree.h"
+#include "../debug.h"
+
+static struct rb_elem *insert (struct rbtree *, struct rb_elem *,
+                               bool unique);
+static void insert_fixup (struct rbtree *, struct rb_elem *);
+static void erase_fixup (struct rbtree *, struct rb_elem *,
+                         struct rb_elem *parent);
+
+/* Initializes TREE as an empty tree ordered by LESS, given
+   auxiliary data AUX. */
+void
+rb_init (struct rbtree *tree, rb_less_func *less, void *aux)
+{
+  ASSERT (tree != NULL);
+  ASSERT (less != NULL);
+
+  tree->root = NULL;
+  tree->elem_cnt = 0;
+  tree->less = less;
+  tree->aux = aux;
+}
+
+/* Returns the leftmost element in the subtree rooted at E. */
+static struct rb_elem *
+leftmost (struct rb_elem *e)
+{
+  while (e->left != NULL)
+    e = e->left;
+  return e;
+}
+
+/* Returns the rightmost element in the subtree rooted at E. */
+static struct rb_elem *
+rightmost (struct rb_elem *e)
+{
+  while (e->right != NULL)
+    e = e->right;
+  return e;
+}
+
+/* Returns the least element in TREE, or rb_end(TREE) if TREE is
+   empty. */
+struct rb_elem *
+rb_begin (struct rbtree *tree)
+{
+  ASSERT (tree != NULL);
+  return tree->root != NULL ? leftmost (tree->root) : NULL;
+}
+
+/* Returns the element after E in its tree, or rb_end() if E is
+   the greatest element. */
+struct rb_elem *
+rb_next (struct rb_elem *e)
+{
+  ASSERT (e != NULL);
+
+  if (e->right != NULL)
+    return leftmost (e->right);
+  while (e->parent != NULL && e == e->parent->right)
+    e = e->parent;
+  return e->parent;
+}
+
+/* Returns TREE's end marker, which follows the greatest element
+   in iteration.  It is a null pointer. */
+struct rb_elem *
+rb_end (struct rbtree *tree UNUSED)
+{
+  return NULL;
+}
+
+/* Returns the greatest element in TREE, or a null pointer if
+   TREE is empty.  Iteration in reverse order starts here and
+   goes on with rb_prev() until a null pointer. */
+struct rb_elem *
+rb_last (struct rbtree *tree)
+{
+  ASSERT (tree != NULL);
+  return tree->root != NULL ? rightmost (tree->root) : NULL;
+}
+
+/* Returns the element before E in its tree, or a null pointer
+   if E is the least element. */
+struct rb_elem *
+rb_prev (struct rb_elem *e)
+{
+  ASSERT (e != NULL);
+
+  if (e->left != NULL)
+    return rightmost (e->left);
+  while (e->parent != NULL && e == e->parent->left)
+    e = e->parent;
+  return e->parent;
+}
+
+/* Inserts ELEM into TREE and returns a null pointer, if no
+   element equal to ELEM is already in TREE.  If an equal element
+   is already in TREE, returns it without inserting ELEM. */
+struct rb_elem *
+rb_insert (struct rbtree *tree, struct rb_elem *elem)
+{
+  return insert (tree, elem, true);
+}
+
+/* Inserts ELEM into TREE, after any elements equal to it. */
+void
+rb_insert_multi (struct rbtree *tree, struct rb_elem *elem)
+{
+  insert (tree, elem, false);
+}
+
+/* Makes NEW take OLD's place as a child of PARENT, or as the
+   root of TREE if PARENT is null. */
+static void
+replace_child (struct rbtree *tree, struct rb_elem *parent,
+               struct rb_elem *old, struct rb_elem *new)
+{
+  if (parent == NULL)
+    tree->root = new;
+  else if (parent->left == old)
+    parent->left = new;
+  else
+    parent->right = new;
+}
+
+/* Rotates the subtree rooted at E to the left, so that E's right
+   child takes its place and E becomes its left child. */
+static void
+rotate_left (struct rbtree *tree, struct rb_elem *e)
+{
+  struct rb_elem *r = e->right;
+
+  e->right = r->left;
+  if (r->left != NULL)
+    r->left->parent = e;
+  r->parent = e->parent;
+  replace_child (tree, e->parent, e, r);
+  r->left = e;
+  e->parent = r;
+}
+
+/* Rotates the subtree rooted at E to the right, so that E's left
+   child takes its place and E becomes its right child. */
+static void
+rotate_right (struct rbtree *tree, struct rb_elem *e)
+{
+  struct rb_elem *l = e->left;
+
+  e->left = l->right;
+  if (l->right != NULL)
+    l->right->parent = e;
+  l->parent = e->parent;
+  replace_child (tree, e->parent, e, l);
+  l->right = e;
+  e->parent = l;
+}
+
+/* Inserts ELEM into TREE, after any equal elements.  If UNIQUE
+   and an element equal to ELEM is already in TREE, returns it
+   without inserting ELEM; otherwise, returns a null pointer. */
+static struct rb_elem *
+insert (struct rbtree *tree, struct rb_elem *elem, bool unique)
+{
+  struct rb_elem **link = &tree->root;
+  struct rb_elem *parent = NULL;
+
+  ASSERT (tree != NULL);
+  ASSERT (elem != NULL);
+
+  while (*link != NULL)
+    {
+      parent = *link;
+      if (tree->less (elem, parent, tree->aux))
+        link = &parent->left;
+      else if (unique && !tree->less (parent, elem, tree->aux))
+        return parent;
+      else
+        link = &parent->right;
+    }
+
+  elem->parent = parent;
+  elem->left = elem->right = NULL;
+  elem->red = true;
+  *link = elem;
+  tree->elem_cnt++;
+  insert_fixup (tree, elem);
+  return NULL;
+}
+
+/* Restores invariant 2 after red element E was added to TREE. */
+static void
+insert_fixup (struct rbtree *tree, struct rb_elem *e)
+{
+  struct rb_elem *parent;
+
+  while ((parent = e->parent) != NULL && parent->red)
+    {
+      /* PARENT is red, so it is not the root. */
+      struct rb_elem *grandparent = parent->parent;
+
+      if (parent == grandparent->left)
+        {
+          struct rb_elem *uncle = grandparent->right;
+
+          if (uncle != NULL && uncle->red)
+            {
+              /* Push the grandparent's blackness down a level
+                 and continue from it. */
+              parent->red = uncle->red = false;
+              grandparent->red = true;
+              e = grandparent;
+            }
+          else
+            {
+              if (e == parent->right)
+                {
+                  rotate_left (tree, parent);
+                  e = parent;
+                  parent = e->parent;
+                }
+              parent->red = false;
+              grandparent->red = true;
+              rotate_right (tree, grandparent);
+            }
+        }
+      else
+        {
+          struct rb_elem *uncle = grandparent->left;
+
+          if (uncle != NULL && uncle->red)
+            {
+              parent->red = uncle->red = false;
+              grandparent->red = true;
+              e = grandparent;
+            }
+          else
+            {
+              if (e == parent->left)
+                {
+                  rotate_right (tree, parent);
+                  e = parent;
+                  parent = e->parent;
+                }
+              parent->red = false;
+              grandparent->red = true;
+              rotate_left (tree, grandparent);
+            }
+        }
+    }
+  tree->root->red = false;
+}
+
+/* Removes ELEM, which must be in TREE, from TREE. */
+void
+rb_erase (struct rbtree *tree, struct rb_elem *elem)
+{
+  struct rb_elem *child, *parent;
+  bool removed_red;
+
+  ASSERT (tree != NULL);
+  ASSERT (elem != NULL);
+  ASSERT (tree->elem_cnt > 0);
+
+  if (elem->left == NULL || elem->right == NULL)
+    {
+      /* Splice ELEM out, moving up its only child, if any. */
+      child = elem->left != NULL ? elem->left : elem->right;
+      parent = elem->parent;
+      removed_red = elem->red;
+      if (child != NULL)
+        child->parent = parent;
+      replace_child (tree, parent, elem, child);
+    }
+  else
+    {
+      /* Splice out ELEM's successor, which has no left child,
+         and put it in ELEM's place and color. */
+      struct rb_elem *next = leftmost (elem->right);
+
+      child = next->right;
+      removed_red = next->red;
+      if (next->parent == elem)
+        parent = next;
+      else
+        {
+          parent = next->parent;
+          if (child != NULL)
+            child->parent = parent;
+          parent->left = child;
+          next->right = elem->right;
+          elem->right->parent = next;
+        }
+      next->left = elem->left;
+      elem->left->parent = next;
+      next->parent = elem->parent;
+      replace_child (tree, elem->parent, elem, next);
+      next->red = elem->red;
+    }
+  tree->elem_cnt--;
+
+  if (!removed_red)
+    erase_fixup (tree, child, parent);
+}
+
+/* Returns true if E is a red element, false if it is black or
+   null. */
+static inline bool
+is_red (const struct rb_elem *e)
+{
+  return e != NULL && e->red;
+}
+
+/* Restores invariant 3 after a black element was removed from
+   TREE, leaving E, which may be null, with one black too few on
+   its paths.  PARENT is E's parent. */
+static void
+erase_fixup (struct rbtree *tree, struct rb_elem *e, struct rb_elem *parent)
+{
+  while (e != tree->root && !is_red (e))
+    {
+      /* E's sibling has at least one black on its paths, so it
+         is not null. */
+      if (e == parent->left)
+        {
+          struct rb_elem *sibling = parent->right;
+
+          if (sibling->red)
+            {
+              sibling->red = false;
+              parent->red = true;
+              rotate_left (tree, parent);
+              sibling = parent->right;
+            }
+          if (!is_red (sibling->left) && !is_red (sibling->right))
+            {
+              /* Move the missing black up a level. */
+              sibling->red = true;
+              e = parent;
+              parent = e->parent;
+            }
+          else
+            {
+              if (!is_red (sibling->right))
+                {
+                  sibling->left->red = false;
+                  sibling->red = true;
+                  rotate_right (tree, sibling);
+                  sibling = parent->right;
+                }
+              sibling->red = parent->red;
+              parent->red = false;
+              sibling->right->red = false;
+              rotate_left (tree, parent);
+              e = tree->root;
+            }
+        }
+      else
+        {
+          struct rb_elem *sibling = parent->left;
+
+          if (sibling->red)
+            {
+              sibling->red = false;
+              parent->red = true;
+              rotate_right (tree, parent);
+              sibling = parent->left;
+            }
+          if (!is_red (sibling->left) && !is_red (sibling->right))
+            {
+              sibling->red = true;
+              e = parent;
+              parent = e->parent;
+            }
+          else
+            {
+              if (!is_red (sibling->left))
+                {
+                  sibling->right->red = false;
+                  sibling->red = true;
+                  rotate_left (tree, sibling);
+                  sibling = parent->left;
+                }
+              sibling->red = parent->red;
+              parent->red = false;
+              sibling->left->red = false;
+              rotate_right (tree, parent);
+              e = tree->root;
+            }
+        }
+    }
+  if (e != NULL)
+    e->red = false;
+}
+
+/* Returns the first element in TREE that is not less than KEY,
+   or rb_end(TREE) if there is none. */
+struct rb_elem *
+rb_lower_bound (struct rbtree *tree, const struct rb_elem *key)
+{
+  struct rb_elem *e = tree->root;
+  struct rb_elem *bound = NULL;
+
+  while (e != NULL)
+    if (tree->less (e, key, tree->aux))
+      e = e->right;
+    else
+      {
+        bound = e;
+        e = e->left;
+      }
+  return bound;
+}
+
+/* Returns the first element in TREE that is greater than KEY,
+   or rb_end(TREE) if there is none. */
+struct rb_elem *
+rb_upper_bound (struct rbtree *tree, const struct rb_elem *key)
+{
+  struct rb_elem *e = tree->root;
+  struct rb_elem *bound = NULL;
+
+  while (e != NULL)
+    if (tree->less (key, e, tree->aux))
+      {
+        bound = e;
+        e = e->left;
+      }
+    else
+      e = e->right;
+  return bound;
+}
+
+/* Returns the first element in TREE equal to KEY, or a null
+   pointer if there is none. */
+struct rb_elem *
+rb_find (struct rbtree *tree, const struct rb_elem *key)
+{
+  struct rb_elem *e = rb_lower_bound (tree, key);
+
+  return e != NULL && !tree->less (key, e, tree->aux) ? e : NULL;
+}
+
+/* Returns the number of elements in TREE. */
+size_t
+rb_size (struct rbtree *tree)
+{
+  return tree->elem_cnt;
+}
+
+/* Returns true if TREE is empty, false otherwise. */
+bool
+rb_empty (struct rbtree *tree)
+{
+  return tree->root == NULL;
+}
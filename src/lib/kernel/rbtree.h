@@ -0,0 +1,93 @@
+#ifndef __LIB_KERNEL_RBTREE_H
+#define __LIB_KERNEL_RBTREE_H
+
+/* Red-black tree.
+
+   A balanced binary search tree, kept in order by a comparison
+   function, for when elements must be found by key or visited
+   in order and a sorted list would make that linear.  Insertion,
+   deletion and lookup take O(log n) time.
+
+   Like lists and hash tables, the tree does not use dynamic
+   allocation: each structure that can be in a tree embeds a
+   struct rb_elem member, and rb_entry() converts a pointer to it
+   back into a pointer to the structure.  Nor does it take locks,
+   so it may be used with interrupts off, given that the caller
+   provides its own synchronization.  Refer to lib/kernel/list.h
+   for a detailed explanation of the embedding technique.
+
+   Iteration in order looks like this:
+
+      struct rb_elem *e;
+
+      for (e = rb_begin (&tree); e != rb_end (&tree); e = rb_next (e))
+        {
+          struct foo *f = rb_entry (e, struct foo, elem);
+          ...do something with f...
+        }
+
+   An element must not be changed in a way that would change its
+   position in the tree while it is in the tree. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Tree element. */
+struct rb_elem
+  {
+    struct rb_elem *parent;     /* Parent, or null for the root. */
+    struct rb_elem *left;       /* Left child, or null. */
+    struct rb_elem *right;      /* Right child, or null. */
+    bool red;                   /* Red, or black? */
+  };
+
+/* Converts pointer to tree element RB_ELEM into a pointer to the
+   structure that RB_ELEM is embedded inside.  Supply the name of
+   the outer structure STRUCT and the member name MEMBER of the
+   tree element. */
+#define rb_entry(RB_ELEM, STRUCT, MEMBER)                       \
+        ((STRUCT *) ((uint8_t *) &(RB_ELEM)->parent             \
+                     - offsetof (STRUCT, MEMBER.parent)))
+
+/* Compares the value of two tree elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool rb_less_func (const struct rb_elem *a,
+                           const struct rb_elem *b,
+                           void *aux);
+
+/* Red-black tree. */
+struct rbtree
+  {
+    struct rb_elem *root;       /* Root, or null if empty. */
+    size_t elem_cnt;            /* Number of elements. */
+    rb_less_func *less;         /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `less'. */
+  };
+
+/* Tree initialization. */
+void rb_init (struct rbtree *, rb_less_func *, void *aux);
+
+/* Tree traversal. */
+struct rb_elem *rb_begin (struct rbtree *);
+struct rb_elem *rb_next (struct rb_elem *);
+struct rb_elem *rb_end (struct rbtree *);
+struct rb_elem *rb_last (struct rbtree *);
+struct rb_elem *rb_prev (struct rb_elem *);
+
+/* Insertion and removal. */
+struct rb_elem *rb_insert (struct rbtree *, struct rb_elem *);
+void rb_insert_multi (struct rbtree *, struct rb_elem *);
+void rb_erase (struct rbtree *, struct rb_elem *);
+
+/* Search. */
+struct rb_elem *rb_find (struct rbtree *, const struct rb_elem *);
+struct rb_elem *rb_lower_bound (struct rbtree *, const struct rb_elem *);
+struct rb_elem *rb_upper_bound (struct rbtree *, const struct rb_elem *);
+
+/* Properties. */
+size_t rb_size (struct rbtree *);
+bool rb_empty (struct rbtree *);
+
+#endif /* lib/kernel/rbtree.h */
@@ -0,0 +1,51 @@
+#ifndef __LIB_RING_H
+#define __LIB_RING_H
+
+#include <stdint.h>
+
+/* System call ring.
+
+   A process may register a `struct ring' in its own memory with
+   ring_setup(), then queue many system calls in it and have the
+   kernel carry out the whole batch with one ring_enter() trap.
+
+   The user fills in the submission queue entry at index
+   SQ_TAIL % RING_ENTRIES and then increments SQ_TAIL.
+   ring_enter() carries out every queued request in order, as
+   long as there is room in the completion queue.  For each one
+   it posts a completion at CQ_TAIL and increments both SQ_HEAD
+   and CQ_TAIL.  The user consumes completions from CQ_HEAD.  The
+   indexes run freely and wrap around modulo 2**32. */
+
+/* Number of entries in each queue.  Must be a power of 2. */
+#define RING_ENTRIES 64
+
+/* A request: system call OPCODE, from syscall-nr.h, with
+   arguments ARGS.  USER_DATA is passed back in the completion.
+   fork and the ring calls themselves cannot be queued. */
+struct ring_sqe
+  {
+    int opcode;                 /* System call number. */
+    uint32_t args[4];           /* Arguments, as for the trap. */
+    uint32_t user_data;         /* Returned in the completion. */
+  };
+
+/* A completion. */
+struct ring_cqe
+  {
+    uint32_t user_data;         /* From the request. */
+    int result;                 /* Return value, -1 if refused. */
+  };
+
+/* A submission queue and a completion queue. */
+struct ring
+  {
+    unsigned sq_head;           /* Next request the kernel takes. */
+    unsigned sq_tail;           /* Next free request slot. */
+    unsigned cq_head;           /* Next completion the user takes. */
+    unsigned cq_tail;           /* Next free completion slot. */
+    struct ring_sqe sq[RING_ENTRIES];
+    struct ring_cqe cq[RING_ENTRIES];
+  };
+
+#endif /* lib/ring.h */
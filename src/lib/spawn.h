@@ -0,0 +1,7 @@
+#ifndef __LIB_SPAWN_H
+#define __LIB_SPAWN_H
+
+/* Flags for spawn(). */
+#define SPAWN_INHERIT_FDS 0x1   /* Child gets each open descriptor. */
+
+#endif /* lib/spawn.h */
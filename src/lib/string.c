@@ -1,5 +1,61 @@
 #include <string.h>
 #include <debug.h>
+#include <stdint.h>
+
+/* Blocks shorter than this are copied or set a byte at a time.
+   Longer ones are done 4 bytes at a time with the string
+   instructions, after aligning the destination. */
+#define WORD_MIN 16
+
+/* Copies SIZE bytes from SRC to DST, lowest address first. */
+static inline void
+copy_up (unsigned char *dst, const unsigned char *src, size_t size) 
+{
+  if (size >= WORD_MIN) 
+    {
+      size_t head = -(uintptr_t) dst & 3;
+      size_t words;
+
+      size -= head;
+      while (head-- > 0)
+        *dst++ = *src++;
+      words = size / 4;
+      asm volatile ("rep movsl"
+                    : "+D" (dst), "+S" (src), "+c" (words) : : "memory");
+      size &= 3;
+    }
+  while (size-- > 0)
+    *dst++ = *src++;
+}
+
+/* Copies SIZE bytes from SRC to DST, highest address first. */
+static inline void
+copy_down (unsigned char *dst, const unsigned char *src, size_t size) 
+{
+  dst += size;
+  src += size;
+  if (size >= WORD_MIN) 
+    {
+      size_t tail = (uintptr_t) dst & 3;
+      size_t words;
+
+      size -= tail;
+      while (tail-- > 0)
+        *--dst = *--src;
+      words = size / 4;
+      dst -= 4;
+      src -= 4;
+      /* Interrupt handlers clear the direction flag themselves, so
+         it is safe to have it set for a moment. */
+      asm volatile ("std; rep movsl; cld"
+                    : "+D" (dst), "+S" (src), "+c" (words) : : "memory");
+      dst += 4;
+      src += 4;
+      size &= 3;
+    }
+  while (size-- > 0)
+    *--dst = *--src;
+}
 
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
@@ -12,8 +68,7 @@ memcpy (void *dst_, const void *src_, size_t size)
   ASSERT (dst != NULL || size == 0);
   ASSERT (src != NULL || size == 0);
 
-  while (size-- > 0)
-    *dst++ = *src++;
+  copy_up (dst, src, size);
 
   return dst_;
 }
@@ -29,20 +84,12 @@ memmove (void *dst_, const void *src_, size_t size)
   ASSERT (dst != NULL || size == 0);
   ASSERT (src != NULL || size == 0);
 
-  if (dst < src) 
-    {
-      while (size-- > 0)
-        *dst++ = *src++;
-    }
-  else 
-    {
-      dst += size;
-      src += size;
-      while (size-- > 0)
-        *--dst = *--src;
-    }
+  if (dst <= src || dst >= src + size)
+    copy_up (dst, src, size);
+  else
+    copy_down (dst, src, size);
 
-  return dst;
+  return dst_;
 }
 
 /* Find the first differing byte in the two blocks of SIZE bytes
@@ -281,7 +328,21 @@ memset (void *dst_, int value, size_t size)
   unsigned char *dst = dst_;
 
   ASSERT (dst != NULL || size == 0);
-  
+
+  if (size >= WORD_MIN) 
+    {
+      uint32_t word = (unsigned char) value * 0x01010101u;
+      size_t head = -(uintptr_t) dst & 3;
+      size_t words;
+
+      size -= head;
+      while (head-- > 0)
+        *dst++ = value;
+      words = size / 4;
+      asm volatile ("rep stosl"
+                    : "+D" (dst), "+c" (words) : "a" (word) : "memory");
+      size &= 3;
+    }
   while (size-- > 0)
     *dst++ = value;
 
@@ -28,7 +28,20 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Extensions. */
+    SYS_FORK,                   /* Duplicate this process. */
+    SYS_SYSENTER,               /* Query fast system call support. */
+    SYS_READV,                  /* Read from a file into several buffers. */
+    SYS_WRITEV,                 /* Write to a file from several buffers. */
+    SYS_PREAD,                  /* Read from a file at a given position. */
+    SYS_PWRITE,                 /* Write to a file at a given position. */
+    SYS_RING_SETUP,             /* Register a system call ring. */
+    SYS_RING_ENTER,             /* Carry out queued system calls. */
+    SYS_SENDFILE,               /* Copy from one file to another. */
+    SYS_SPAWN,                  /* Start another process from an argv. */
+    SYS_WAITANY                 /* Wait for whichever child exits. */
   };
 
 #endif /* lib/syscall-nr.h */
@@ -3,6 +3,9 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <ring.h>
+#include <spawn.h>
+#include <uio.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -45,4 +48,18 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Extensions. */
+pid_t fork (void);
+void syscall_fast_init (void);
+int readv (int fd, const struct iovec *, int iovcnt);
+int writev (int fd, const struct iovec *, int iovcnt);
+int pread (int fd, void *buffer, unsigned length, unsigned position);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned position);
+bool ring_setup (struct ring *);
+int ring_enter (void);
+int sendfile (int out_fd, int in_fd, unsigned length);
+pid_t spawn (char *const argv[], int flags);
+pid_t waitany (int *status);
+pid_t waitany_timeout (int *status, int timeout_ms);
+
 #endif /* lib/user/syscall.h */
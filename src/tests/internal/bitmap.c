@@ -0,0 +1,123 @@
+/* Test program for lib/kernel/bitmap.c.
+
+   Checks bitmap_scan() against a bit-by-bit search on bitmaps of
+   various sizes and fullness, then measures how long it takes
+   to find every free run in a 64k-bit map that is 10%, 50% and
+   95% full.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <bitmap.h>
+#include <cpu.h>
+#include <debug.h>
+#include <random.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/test.h"
+
+/* Number of bits in the benchmark bitmap. */
+#define BENCH_BITS 65536
+
+/* Largest bitmap checked against the reference search. */
+#define MAX_SIZE 200
+
+/* Sets each bit in B to true with probability PERCENT / 100. */
+static void
+fill (struct bitmap *b, int percent) 
+{
+  size_t i;
+
+  for (i = 0; i < bitmap_size (b); i++)
+    bitmap_set (b, i, (int) (random_ulong () % 100) < percent);
+}
+
+/* Returns what bitmap_scan (B, START, CNT, VALUE) should. */
+static size_t
+reference_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) 
+{
+  size_t i, j;
+
+  for (i = start; i + cnt <= bitmap_size (b); i++) 
+    {
+      for (j = 0; j < cnt; j++)
+        if (bitmap_test (b, i + j) != value)
+          break;
+      if (j == cnt)
+        return i;
+    }
+  return BITMAP_ERROR;
+}
+
+/* Counts the free runs of CNT bits in B, as an allocator that
+   kept taking the first one would find them. */
+static int
+scan_all (const struct bitmap *b, size_t cnt) 
+{
+  size_t start = 0;
+  int found = 0;
+
+  for (;;) 
+    {
+      size_t idx = bitmap_scan (b, start, cnt, false);
+      if (idx == BITMAP_ERROR)
+        return found;
+      found++;
+      start = idx + cnt;
+    }
+}
+
+void
+test (void) 
+{
+  static const int percents[] = {10, 50, 95};
+  static const size_t cnts[] = {1, 4, 16};
+  struct bitmap *b;
+  size_t size;
+  int i, j;
+
+  printf ("checking bitmap_scan against reference:");
+  for (size = 0; size <= MAX_SIZE; size += 7) 
+    {
+      int percent;
+
+      printf (" %zu", size);
+      b = bitmap_create (size);
+      ASSERT (b != NULL);
+      for (percent = 0; percent <= 100; percent += 25) 
+        {
+          size_t start, cnt;
+
+          fill (b, percent);
+          for (start = 0; start <= size; start += 3)
+            for (cnt = 0; cnt <= 9; cnt++) 
+              {
+                ASSERT (bitmap_scan (b, start, cnt, false)
+                        == reference_scan (b, start, cnt, false));
+                ASSERT (bitmap_scan (b, start, cnt, true)
+                        == reference_scan (b, start, cnt, true));
+              }
+        }
+      bitmap_destroy (b);
+    }
+  printf (" done\n");
+
+  b = bitmap_create (BENCH_BITS);
+  ASSERT (b != NULL);
+  for (i = 0; i < (int) (sizeof percents / sizeof *percents); i++) 
+    {
+      fill (b, percents[i]);
+      for (j = 0; j < (int) (sizeof cnts / sizeof *cnts); j++) 
+        {
+          uint64_t start = rdtsc ();
+          int found = scan_all (b, cnts[j]);
+          printf ("%d%% full, runs of %zu: %d found in %d kcycles\n",
+                  percents[i], cnts[j], found,
+                  (int) ((rdtsc () - start) / 1000));
+        }
+    }
+  bitmap_destroy (b);
+  printf ("bitmap: PASS\n");
+}
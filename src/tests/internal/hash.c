@@ -0,0 +1,169 @@
+/* Test program for lib/kernel/hash.c.
+
+   Checks tables made with hash_init() and with
+   hash_init_incremental() against a flag per key, under random
+   insertions, lookups and deletions that grow and shrink them
+   through several resizes, and checks iteration along the way.
+   Then it inserts 16384 elements into each kind of table and
+   reports the average and the slowest insertion in cycles.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <cpu.h>
+#include <debug.h>
+#include <hash.h>
+#include <random.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/test.h"
+
+/* Number of elements. */
+#define ELEM_CNT 16384
+
+/* A table element. */
+struct item
+  {
+    struct hash_elem elem;
+    int key;
+    bool in;                    /* In the table? */
+  };
+
+static struct item items[ELEM_CNT];
+
+static unsigned
+item_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  return hash_int (hash_entry (e, struct item, elem)->key);
+}
+
+static bool
+item_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux UNUSED)
+{
+  return (hash_entry (a, struct item, elem)->key
+          < hash_entry (b, struct item, elem)->key);
+}
+
+/* Sets up H, incrementally resized if INCREMENTAL. */
+static void
+init (struct hash *h, bool incremental)
+{
+  int i;
+
+  for (i = 0; i < ELEM_CNT; i++)
+    {
+      items[i].key = i;
+      items[i].in = false;
+    }
+  ASSERT (incremental
+          ? hash_init_incremental (h, item_hash, item_less, NULL)
+          : hash_init (h, item_hash, item_less, NULL));
+}
+
+/* Checks that iterating H visits exactly the elements marked as
+   in it. */
+static void
+check_iteration (struct hash *h)
+{
+  struct hash_iterator i;
+  size_t cnt = 0;
+
+  hash_first (&i, h);
+  while (hash_next (&i))
+    {
+      ASSERT (hash_entry (hash_cur (&i), struct item, elem)->in);
+      cnt++;
+    }
+  ASSERT (cnt == hash_size (h));
+}
+
+/* Runs random operations on a table, in phases that alternately
+   fill it up over all the keys and drain it down to a few. */
+static void
+check (bool incremental)
+{
+  struct hash h;
+  size_t cnt = 0;
+  int phase, i;
+
+  init (&h, incremental);
+  for (phase = 0; phase < 6; phase++)
+    for (i = 0; i < 4 * ELEM_CNT; i++)
+      {
+        int key = random_ulong () % ELEM_CNT;
+        struct item probe;
+        struct hash_elem *e;
+
+        probe.key = key;
+        switch (random_ulong () % 4)
+          {
+          case 0:
+          case 1:
+            /* Insert while filling, delete while draining. */
+            if (phase % 2 == 0)
+              {
+                e = hash_insert (&h, &items[key].elem);
+                ASSERT ((e != NULL) == items[key].in);
+                cnt += !items[key].in;
+                items[key].in = true;
+              }
+            else
+              {
+                e = hash_delete (&h, &probe.elem);
+                ASSERT ((e != NULL) == items[key].in);
+                cnt -= items[key].in;
+                items[key].in = false;
+              }
+            break;
+          case 2:
+            e = hash_find (&h, &probe.elem);
+            ASSERT ((e != NULL) == items[key].in);
+            break;
+          case 3:
+            if (i % 1024 == 0)
+              check_iteration (&h);
+            break;
+          }
+        ASSERT (hash_size (&h) == cnt);
+      }
+  hash_destroy (&h, NULL);
+}
+
+/* Inserts every element into a table and prints the average and
+   the slowest insertion. */
+static void
+bench (bool incremental)
+{
+  struct hash h;
+  uint64_t total = 0, worst = 0;
+  int i;
+
+  init (&h, incremental);
+  for (i = 0; i < ELEM_CNT; i++)
+    {
+      uint64_t start = rdtsc ();
+      uint64_t cycles;
+
+      hash_insert (&h, &items[i].elem);
+      cycles = rdtsc () - start;
+      total += cycles;
+      if (cycles > worst)
+        worst = cycles;
+    }
+  printf ("%s: %d inserts, %d cycles average, %d cycles worst\n",
+          incremental ? "incremental" : "all at once", ELEM_CNT,
+          (int) (total / ELEM_CNT), (int) worst);
+  hash_destroy (&h, NULL);
+}
+
+void
+test (void)
+{
+  check (false);
+  check (true);
+  bench (false);
+  bench (true);
+}
@@ -0,0 +1,210 @@
+/* Test program for lib/kernel/ihash.c.
+
+   Checks ihash against the chained hash table in hash.c under a
+   random mix of insertions, lookups and deletions, and checks
+   now and then that iterating with ihash_first() and applying
+   an action with ihash_apply() visit the same entries.  Then it
+   compares how many cycles each table takes to insert, find and
+   delete 4096 integer keys, both consecutive (like thread ids)
+   and random.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <cpu.h>
+#include <debug.h>
+#include <hash.h>
+#include <ihash.h>
+#include <random.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/test.h"
+
+/* Number of keys in the benchmark. */
+#define KEY_CNT 4096
+
+/* An element of the chained table. */
+struct item
+  {
+    struct hash_elem elem;
+    unsigned key;
+  };
+
+static struct item items[KEY_CNT];
+
+/* Number of entries seen by count_slot(). */
+static size_t apply_cnt;
+
+static unsigned
+item_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  return hash_int (hash_entry (e, struct item, elem)->key);
+}
+
+static bool
+item_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux UNUSED)
+{
+  return (hash_entry (a, struct item, elem)->key
+          < hash_entry (b, struct item, elem)->key);
+}
+
+/* Returns the item with KEY in chained table H, or a null
+   pointer. */
+static struct item *
+chained_find (struct hash *h, unsigned key)
+{
+  struct item probe;
+  struct hash_elem *e;
+
+  probe.key = key;
+  e = hash_find (h, &probe.elem);
+  return e != NULL ? hash_entry (e, struct item, elem) : NULL;
+}
+
+/* Checks that SLOT holds the same item as chained table
+   CHAINED_, and counts it. */
+static void
+count_slot (struct ihash_slot *slot, void *chained_)
+{
+  struct hash *chained = chained_;
+  struct item *item = chained_find (chained, slot->key);
+
+  ASSERT (item != NULL && slot->value == item);
+  apply_cnt++;
+}
+
+/* Checks that iterating OPEN, and applying an action to it,
+   visits exactly the entries in CHAINED. */
+static void
+check_iteration (struct ihash *open, struct hash *chained)
+{
+  struct ihash_iterator i;
+  size_t cnt = 0;
+
+  ihash_first (&i, open);
+  while (ihash_next (&i))
+    {
+      struct ihash_slot *slot = ihash_cur (&i);
+      ASSERT (slot->value == chained_find (chained, slot->key));
+      cnt++;
+    }
+  ASSERT (cnt == hash_size (chained));
+
+  apply_cnt = 0;
+  ihash_apply (open, count_slot);
+  ASSERT (apply_cnt == hash_size (chained));
+}
+
+/* Applies random operations on keys below KEY_CNT / 8 to both
+   tables and checks that they agree. */
+static void
+check (void)
+{
+  struct hash chained;
+  struct ihash open;
+  int i;
+
+  ASSERT (hash_init (&chained, item_hash, item_less, NULL));
+  ASSERT (ihash_init (&open, &chained));
+  for (i = 0; i < 100000; i++)
+    {
+      unsigned key = random_ulong () % (KEY_CNT / 8);
+      struct item *item = chained_find (&chained, key);
+
+      switch (random_ulong () % 3)
+        {
+        case 0:
+          if (item == NULL)
+            {
+              items[key].key = key;
+              hash_insert (&chained, &items[key].elem);
+              ASSERT (ihash_insert (&open, key, &items[key]));
+            }
+          break;
+        case 1:
+          ASSERT (ihash_find (&open, key) == item);
+          break;
+        case 2:
+          if (item != NULL)
+            hash_delete (&chained, &item->elem);
+          ASSERT (ihash_delete (&open, key) == item);
+          break;
+        }
+      ASSERT (hash_size (&chained) == ihash_size (&open));
+      if (i % 1024 == 0)
+        check_iteration (&open, &chained);
+    }
+  check_iteration (&open, &chained);
+  hash_destroy (&chained, NULL);
+  ihash_destroy (&open, NULL);
+}
+
+/* Times inserting, finding and deleting KEYS in each table and
+   prints the cycles per operation. */
+static void
+bench (const char *name, const unsigned keys[])
+{
+  struct hash chained;
+  struct ihash open;
+  uint64_t insert, find, delete;
+  int i;
+
+  ASSERT (hash_init (&chained, item_hash, item_less, NULL));
+  insert = rdtsc ();
+  for (i = 0; i < KEY_CNT; i++)
+    {
+      items[i].key = keys[i];
+      hash_insert (&chained, &items[i].elem);
+    }
+  find = rdtsc ();
+  for (i = 0; i < KEY_CNT; i++)
+    ASSERT (chained_find (&chained, keys[i]) != NULL);
+  delete = rdtsc ();
+  for (i = 0; i < KEY_CNT; i++)
+    hash_delete (&chained, &items[i].elem);
+  printf ("%s keys, chained: insert %d, find %d, delete %d cycles\n",
+          name, (int) ((find - insert) / KEY_CNT),
+          (int) ((delete - find) / KEY_CNT),
+          (int) ((rdtsc () - delete) / KEY_CNT));
+  hash_destroy (&chained, NULL);
+
+  ASSERT (ihash_init (&open, NULL));
+  insert = rdtsc ();
+  for (i = 0; i < KEY_CNT; i++)
+    ASSERT (ihash_insert (&open, keys[i], &items[i]));
+  find = rdtsc ();
+  for (i = 0; i < KEY_CNT; i++)
+    ASSERT (ihash_find (&open, keys[i]) != NULL);
+  delete = rdtsc ();
+  for (i = 0; i < KEY_CNT; i++)
+    ASSERT (ihash_delete (&open, keys[i]) != NULL);
+  printf ("%s keys, open: insert %d, find %d, delete %d cycles\n",
+          name, (int) ((find - insert) / KEY_CNT),
+          (int) ((delete - find) / KEY_CNT),
+          (int) ((rdtsc () - delete) / KEY_CNT));
+  ihash_destroy (&open, NULL);
+}
+
+void
+test (void)
+{
+  static unsigned keys[KEY_CNT];
+  unsigned multiplier;
+  int i;
+
+  check ();
+
+  for (i = 0; i < KEY_CNT; i++)
+    keys[i] = i + 1;
+  bench ("consecutive", keys);
+
+  /* Distinct, scattered keys: multiplying by an odd number is a
+     bijection on 32-bit integers. */
+  multiplier = random_ulong () | 1;
+  for (i = 0; i < KEY_CNT; i++)
+    keys[i] = (i + 1) * multiplier;
+  bench ("random", keys);
+}
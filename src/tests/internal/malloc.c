@@ -0,0 +1,88 @@
+/* Test program for the magazines in threads/malloc.c.
+
+   Runs 1,000,000 malloc() and free() pairs, split evenly among
+   1, 2, 4 and 8 threads, and reports the cycles per pair.  Each
+   thread keeps a few blocks of several sizes live at a time, so
+   its frees are not just the block it allocated last.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <cpu.h>
+#include <debug.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/test.h"
+#include "threads/thread.h"
+
+/* Total malloc()/free() pairs in each round. */
+#define PAIRS 1000000
+
+/* Blocks each thread keeps live. */
+#define LIVE 8
+
+/* Work for one thread. */
+struct worker
+  {
+    int pairs;                  /* Pairs to do. */
+    struct semaphore *done;     /* Upped when finished. */
+  };
+
+/* Does a worker's malloc()/free() pairs. */
+static void
+churn (void *worker_)
+{
+  struct worker *w = worker_;
+  void *live[LIVE] = { NULL };
+  int i;
+
+  for (i = 0; i < w->pairs; i++)
+    {
+      int slot = i % LIVE;
+
+      free (live[slot]);
+      live[slot] = malloc (16 << (i % 5));
+      ASSERT (live[slot] != NULL);
+    }
+  for (i = 0; i < LIVE; i++)
+    free (live[i]);
+  sema_up (w->done);
+}
+
+/* Runs PAIRS pairs split among THREAD_CNT threads and returns
+   the cycles per pair. */
+static int
+run (int thread_cnt)
+{
+  struct worker workers[8];
+  struct semaphore done;
+  uint64_t start;
+  int i;
+
+  ASSERT (thread_cnt <= 8);
+  sema_init (&done, 0);
+  start = rdtsc ();
+  for (i = 0; i < thread_cnt; i++)
+    {
+      workers[i].pairs = PAIRS / thread_cnt;
+      workers[i].done = &done;
+      thread_create ("churn", PRI_DEFAULT, churn, &workers[i]);
+    }
+  for (i = 0; i < thread_cnt; i++)
+    sema_down (&done);
+  return (rdtsc () - start) / PAIRS;
+}
+
+void
+test (void)
+{
+  int thread_cnt;
+
+  for (thread_cnt = 1; thread_cnt <= 8; thread_cnt *= 2)
+    printf ("%d threads: %d cycles per malloc/free pair\n",
+            thread_cnt, run (thread_cnt));
+}
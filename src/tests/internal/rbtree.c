@@ -0,0 +1,225 @@
+/* Test program for lib/kernel/rbtree.c.
+
+   Inserts and erases random elements, checking after each step
+   that the tree is ordered and balanced, that in-order iteration
+   visits every element in both directions, and that rb_find(),
+   rb_lower_bound() and rb_upper_bound() agree with a search of
+   a flag per key.  Then it compares inserting 4096 elements in
+   random order into a tree against list_insert_ordered(), with
+   interrupts off, since the tree never blocks.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <cpu.h>
+#include <debug.h>
+#include <list.h>
+#include <random.h>
+#include <rbtree.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/test.h"
+
+/* Number of keys in the correctness check. */
+#define CHECK_CNT 256
+
+/* Number of elements in the benchmark. */
+#define BENCH_CNT 4096
+
+/* An element in a tree or a list. */
+struct value
+  {
+    struct rb_elem rb_elem;     /* Tree element. */
+    struct list_elem list_elem; /* List element. */
+    int value;                  /* Item value. */
+    bool in;                    /* In the tree? */
+  };
+
+static struct value values[BENCH_CNT];
+
+/* Returns true if value A is less than value B, false
+   otherwise. */
+static bool
+rb_value_less (const struct rb_elem *a_, const struct rb_elem *b_,
+               void *aux UNUSED)
+{
+  const struct value *a = rb_entry (a_, struct value, rb_elem);
+  const struct value *b = rb_entry (b_, struct value, rb_elem);
+  return a->value < b->value;
+}
+
+/* Returns true if value A is less than value B, false
+   otherwise. */
+static bool
+list_value_less (const struct list_elem *a_, const struct list_elem *b_,
+                 void *aux UNUSED)
+{
+  const struct value *a = list_entry (a_, struct value, list_elem);
+  const struct value *b = list_entry (b_, struct value, list_elem);
+  return a->value < b->value;
+}
+
+/* Checks the red-black invariants and parent links in the
+   subtree rooted at E, whose parent is PARENT, and returns its
+   black height. */
+static int
+verify (const struct rb_elem *e, const struct rb_elem *parent)
+{
+  int left, right;
+
+  if (e == NULL)
+    return 1;
+  ASSERT (e->parent == parent);
+  if (e->red)
+    {
+      ASSERT (e->left == NULL || !e->left->red);
+      ASSERT (e->right == NULL || !e->right->red);
+    }
+  left = verify (e->left, e);
+  right = verify (e->right, e);
+  ASSERT (left == right);
+  return left + !e->red;
+}
+
+/* Returns the element in the tree with the least key not less
+   than KEY, by searching the flags, or a null pointer. */
+static struct rb_elem *
+expected_bound (int key)
+{
+  for (; key < CHECK_CNT; key++)
+    if (values[key].in)
+      return &values[key].rb_elem;
+  return NULL;
+}
+
+/* Checks everything about TREE, which holds CNT elements. */
+static void
+check_tree (struct rbtree *tree, size_t cnt)
+{
+  struct rb_elem *e;
+  struct value probe;
+  size_t seen;
+  int key, prev;
+
+  ASSERT (rb_size (tree) == cnt);
+  ASSERT (rb_empty (tree) == (cnt == 0));
+  ASSERT (tree->root == NULL || !tree->root->red);
+  verify (tree->root, NULL);
+
+  seen = 0;
+  prev = -1;
+  for (e = rb_begin (tree); e != rb_end (tree); e = rb_next (e))
+    {
+      struct value *v = rb_entry (e, struct value, rb_elem);
+      ASSERT (v->in && v->value > prev);
+      prev = v->value;
+      seen++;
+    }
+  ASSERT (seen == cnt);
+
+  seen = 0;
+  prev = CHECK_CNT;
+  for (e = rb_last (tree); e != NULL; e = rb_prev (e))
+    {
+      struct value *v = rb_entry (e, struct value, rb_elem);
+      ASSERT (v->value < prev);
+      prev = v->value;
+      seen++;
+    }
+  ASSERT (seen == cnt);
+
+  for (key = 0; key < CHECK_CNT; key++)
+    {
+      probe.value = key;
+      ASSERT (rb_find (tree, &probe.rb_elem)
+              == (values[key].in ? &values[key].rb_elem : NULL));
+      ASSERT (rb_lower_bound (tree, &probe.rb_elem) == expected_bound (key));
+      ASSERT (rb_upper_bound (tree, &probe.rb_elem)
+              == expected_bound (key + 1));
+    }
+}
+
+/* Inserts and erases random elements, checking the tree after
+   each change. */
+static void
+check (void)
+{
+  struct rbtree tree;
+  size_t cnt = 0;
+  int i;
+
+  rb_init (&tree, rb_value_less, NULL);
+  for (i = 0; i < CHECK_CNT; i++)
+    {
+      values[i].value = i;
+      values[i].in = false;
+    }
+
+  for (i = 0; i < 8 * CHECK_CNT; i++)
+    {
+      struct value *v = &values[random_ulong () % CHECK_CNT];
+
+      if (!v->in)
+        {
+          ASSERT (rb_insert (&tree, &v->rb_elem) == NULL);
+          v->in = true;
+          cnt++;
+        }
+      else if (random_ulong () % 2)
+        {
+          rb_erase (&tree, &v->rb_elem);
+          v->in = false;
+          cnt--;
+        }
+      else
+        ASSERT (rb_insert (&tree, &v->rb_elem) == &v->rb_elem);
+      check_tree (&tree, cnt);
+    }
+}
+
+/* Compares inserting BENCH_CNT values in random order into a
+   tree and into a sorted list. */
+static void
+bench (void)
+{
+  struct rbtree tree;
+  struct list list;
+  enum intr_level old_level;
+  uint64_t start, tree_cycles, list_cycles;
+  int i;
+
+  for (i = 0; i < BENCH_CNT; i++)
+    values[i].value = random_ulong ();
+
+  old_level = intr_disable ();
+  rb_init (&tree, rb_value_less, NULL);
+  start = rdtsc ();
+  for (i = 0; i < BENCH_CNT; i++)
+    rb_insert_multi (&tree, &values[i].rb_elem);
+  for (i = 0; i < BENCH_CNT; i++)
+    rb_erase (&tree, &values[i].rb_elem);
+  tree_cycles = rdtsc () - start;
+
+  list_init (&list);
+  start = rdtsc ();
+  for (i = 0; i < BENCH_CNT; i++)
+    list_insert_ordered (&list, &values[i].list_elem, list_value_less, NULL);
+  for (i = 0; i < BENCH_CNT; i++)
+    list_remove (&values[i].list_elem);
+  list_cycles = rdtsc () - start;
+  intr_set_level (old_level);
+
+  printf ("%d inserts and removals: tree %d, sorted list %d cycles each\n",
+          BENCH_CNT, (int) (tree_cycles / BENCH_CNT),
+          (int) (list_cycles / BENCH_CNT));
+}
+
+void
+test (void)
+{
+  check ();
+  bench ();
+}
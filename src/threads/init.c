@@ -19,6 +19,7 @@
 #include "threads/io.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
@@ -26,11 +27,17 @@
 #include "userprog/process.h"
 #include "userprog/exception.h"
 #include "userprog/gdt.h"
+#include "userprog/image.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
 #else
 #include "tests/threads/tests.h"
 #endif
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/share.h"
+#endif
 #ifdef FILESYS
 #include "devices/block.h"
 #include "devices/ide.h"
@@ -57,6 +64,11 @@ static const char *swap_bdev_name;
 /* -ul: Maximum number of pages to put into palloc's user pool. */
 static size_t user_page_limit = SIZE_MAX;
 
+#ifdef VM
+/* -fa: Number of file pages to map per page fault. */
+static size_t fault_around_pages = 8;
+#endif
+
 static void bss_init (void);
 static void paging_init (void);
 
@@ -97,7 +109,13 @@ main (void)
   /* Initialize memory system. */
   palloc_init (user_page_limit);
   malloc_init ();
+  slab_init ();
   paging_init ();
+#ifdef VM
+  frame_init ();
+  page_init (fault_around_pages);
+  share_init ();
+#endif
 
   /* Segmentation. */
 #ifdef USERPROG
@@ -113,6 +131,8 @@ main (void)
 #ifdef USERPROG
   exception_init ();
   syscall_init ();
+  image_init ();
+  process_caches_init ();
 #endif
 
   /* Start thread scheduler and enable interrupts. */
@@ -263,6 +283,10 @@ parse_options (char **argv)
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-fa"))
+        fault_around_pages = atoi (value);
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -385,6 +409,9 @@ usage (void)
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+          "  -fa=COUNT          Map up to COUNT file pages per page fault.\n"
 #endif
           );
   shutdown_power_off ();
@@ -5,41 +5,60 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* A simple implementation of malloc().
 
    The size of each request, in bytes, is rounded up to a power
    of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
-   the free list is nonempty, one of its blocks is used to
-   satisfy the request.
-
-   Otherwise, a new page of memory, called an "arena", is
-   obtained from the page allocator (if none is available,
-   malloc() returns a null pointer).  The new arena is divided
-   into blocks, all of which are added to the descriptor's free
-   list.  Then we return one of the new blocks.
-
-   When we free a block, we add it to its descriptor's free list.
-   But if the arena that the block was in now has no in-use
-   blocks, we remove all of the arena's blocks from the free list
-   and give the arena back to the page allocator.
+   that size.  Blocks are carved out of pages of memory, called
+   "arenas", obtained from the page allocator.  Each arena keeps
+   its own list of free blocks, and the descriptor keeps a list
+   of the arenas that have any.
+
+   A request is satisfied from the fullest arena on that list,
+   so that live blocks stay packed into as few arenas as
+   possible and the emptier ones get a chance to drain.  If the
+   list is empty, a new arena is obtained from the page
+   allocator (if none is available, malloc() returns a null
+   pointer) and divided into free blocks.
+
+   When we free a block, we add it to its arena's free list.  If
+   the arena now has no in-use blocks, we give it back to the
+   page allocator.
 
    We can't handle blocks bigger than 2 kB using this scheme,
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   the beginning of the allocated block's arena header.
+
+   Each thread also keeps a "magazine" of free blocks of each
+   size, which only it touches, so most calls to malloc() and
+   free() need no lock at all.  An empty magazine is refilled
+   with a batch of blocks from the descriptor's arenas under the
+   descriptor's lock, and a full one gives a batch back the same
+   way.  Blocks in a magazine count as in use for their arena,
+   so a batch is at most half an arena: otherwise a thread could
+   pin several mostly idle pages of the larger sizes.  A thread
+   empties its magazines back into the arenas when it exits. */
+
+/* Most blocks moved between a magazine and a free list at a
+   time.  A magazine holds up to twice its descriptor's batch. */
+#define MAG_BATCH 8
 
 /* Descriptor. */
 struct desc
   {
     size_t block_size;          /* Size of each element in bytes. */
     size_t blocks_per_arena;    /* Number of blocks in an arena. */
-    struct list free_list;      /* List of free blocks. */
+    size_t mag_batch;           /* Blocks per magazine refill or flush. */
+    struct list arenas;         /* Arenas with free blocks. */
+    size_t arena_cnt;           /* Number of arenas, full or not. */
     struct lock lock;           /* Lock. */
   };
 
@@ -52,20 +71,29 @@ struct arena
     unsigned magic;             /* Always set to ARENA_MAGIC. */
     struct desc *desc;          /* Owning descriptor, null for big block. */
     size_t free_cnt;            /* Free blocks; pages in big block. */
+    struct block *free;         /* Free blocks. */
+    struct list_elem elem;      /* In desc's list while FREE_CNT > 0. */
   };
 
 /* Free block. */
 struct block 
   {
-    struct list_elem free_elem; /* Free list element. */
+    struct block *next;         /* Next block in arena or magazine. */
   };
 
+/* Pages held by big blocks. */
+static size_t big_page_cnt;
+
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[MALLOC_CLASS_CNT]; /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static struct arena *arena_create (struct desc *);
+static bool mag_refill (struct desc *, struct malloc_magazine *);
+static void mag_flush (struct desc *, struct malloc_magazine *,
+                       size_t cnt);
 
 /* Initializes the malloc() descriptors. */
 void
@@ -79,9 +107,43 @@ malloc_init (void)
       ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
       d->block_size = block_size;
       d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
-      list_init (&d->free_list);
+      d->mag_batch = d->blocks_per_arena / 2;
+      if (d->mag_batch > MAG_BATCH)
+        d->mag_batch = MAG_BATCH;
+      list_init (&d->arenas);
+      d->arena_cnt = 0;
       lock_init (&d->lock);
     }
+  ASSERT (desc_cnt == MALLOC_CLASS_CNT);
+}
+
+/* Returns the running thread's magazine for descriptor D. */
+static struct malloc_magazine *
+magazine (struct desc *d) 
+{
+  return &thread_current ()->magazines[d - descs];
+}
+
+/* Removes and returns the top block of magazine M, which must
+   not be empty. */
+static struct block *
+mag_pop (struct malloc_magazine *m) 
+{
+  struct block *b = m->top;
+
+  ASSERT (m->cnt > 0);
+  m->top = b->next;
+  m->cnt--;
+  return b;
+}
+
+/* Pushes block B onto magazine M. */
+static void
+mag_push (struct malloc_magazine *m, struct block *b) 
+{
+  b->next = m->top;
+  m->top = b;
+  m->cnt++;
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -90,7 +152,7 @@ void *
 malloc (size_t size) 
 {
   struct desc *d;
-  struct block *b;
+  struct malloc_magazine *m;
   struct arena *a;
 
   /* A null pointer satisfies a request for 0 bytes. */
@@ -107,9 +169,14 @@ malloc (size_t size)
       /* SIZE is too big for any descriptor.
          Allocate enough pages to hold SIZE plus an arena. */
       size_t page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
+      enum intr_level old_level;
+
       a = palloc_get_multiple (0, page_cnt);
       if (a == NULL)
         return NULL;
+      old_level = intr_disable ();
+      big_page_cnt += page_cnt;
+      intr_set_level (old_level);
 
       /* Initialize the arena to indicate a big block of PAGE_CNT
          pages, and return it. */
@@ -119,38 +186,11 @@ malloc (size_t size)
       return a + 1;
     }
 
-  lock_acquire (&d->lock);
-
-  /* If the free list is empty, create a new arena. */
-  if (list_empty (&d->free_list))
-    {
-      size_t i;
-
-      /* Allocate a page. */
-      a = palloc_get_page (0);
-      if (a == NULL) 
-        {
-          lock_release (&d->lock);
-          return NULL; 
-        }
-
-      /* Initialize arena and add its blocks to the free list. */
-      a->magic = ARENA_MAGIC;
-      a->desc = d;
-      a->free_cnt = d->blocks_per_arena;
-      for (i = 0; i < d->blocks_per_arena; i++) 
-        {
-          struct block *b = arena_to_block (a, i);
-          list_push_back (&d->free_list, &b->free_elem);
-        }
-    }
-
-  /* Get a block from free list and return it. */
-  b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-  a = block_to_arena (b);
-  a->free_cnt--;
-  lock_release (&d->lock);
-  return b;
+  ASSERT (!intr_context ());
+  m = magazine (d);
+  if (m->cnt == 0 && !mag_refill (d, m))
+    return NULL;
+  return mag_pop (m);
 }
 
 /* Allocates and return A times B bytes initialized to zeroes.
@@ -227,42 +267,188 @@ free (void *p)
       if (d != NULL) 
         {
           /* It's a normal block.  We handle it here. */
+          struct malloc_magazine *m;
 
 #ifndef NDEBUG
           /* Clear the block to help detect use-after-free bugs. */
           memset (b, 0xcc, d->block_size);
 #endif
   
-          lock_acquire (&d->lock);
-
-          /* Add block to free list. */
-          list_push_front (&d->free_list, &b->free_elem);
-
-          /* If the arena is now entirely unused, free it. */
-          if (++a->free_cnt >= d->blocks_per_arena) 
-            {
-              size_t i;
-
-              ASSERT (a->free_cnt == d->blocks_per_arena);
-              for (i = 0; i < d->blocks_per_arena; i++) 
-                {
-                  struct block *b = arena_to_block (a, i);
-                  list_remove (&b->free_elem);
-                }
-              palloc_free_page (a);
-            }
-
-          lock_release (&d->lock);
+          ASSERT (!intr_context ());
+          m = magazine (d);
+          if (m->cnt >= 2 * d->mag_batch)
+            mag_flush (d, m, d->mag_batch);
+          mag_push (m, b);
         }
       else
         {
           /* It's a big block.  Free its pages. */
+          enum intr_level old_level = intr_disable ();
+          big_page_cnt -= a->free_cnt;
+          intr_set_level (old_level);
           palloc_free_multiple (a, a->free_cnt);
           return;
         }
     }
 }
 
+/* Empties the running thread's magazines back into the free
+   lists.  Called when the thread exits, after its last call to
+   free(). */
+void
+malloc_thread_exit (void) 
+{
+  struct desc *d;
+
+  for (d = descs; d < descs + desc_cnt; d++)
+    {
+      struct malloc_magazine *m = magazine (d);
+      if (m->cnt > 0)
+        mag_flush (d, m, m->cnt);
+    }
+}
+
+/* Returns the arena in D's list with the fewest free blocks, or
+   a null pointer if the list is empty.  D's lock must be held. */
+static struct arena *
+fullest_arena (struct desc *d) 
+{
+  struct arena *best = NULL;
+  struct list_elem *e;
+
+  for (e = list_begin (&d->arenas); e != list_end (&d->arenas);
+       e = list_next (e))
+    {
+      struct arena *a = list_entry (e, struct arena, elem);
+      if (best == NULL || a->free_cnt < best->free_cnt)
+        best = a;
+    }
+  return best;
+}
+
+/* Moves up to D's batch of blocks into magazine M, which must be
+   empty, taking them from D's fullest arenas and creating a new
+   arena if they run out.  Returns true if at least one block
+   was moved, false if memory is not available. */
+static bool
+mag_refill (struct desc *d, struct malloc_magazine *m) 
+{
+  ASSERT (m->cnt == 0);
+
+  lock_acquire (&d->lock);
+  while (m->cnt < d->mag_batch)
+    {
+      struct arena *a = fullest_arena (d);
+      if (a == NULL)
+        {
+          a = arena_create (d);
+          if (a == NULL)
+            break;
+        }
+
+      while (a->free_cnt > 0 && m->cnt < d->mag_batch)
+        {
+          struct block *b = a->free;
+          a->free = b->next;
+          a->free_cnt--;
+          mag_push (m, b);
+        }
+      if (a->free_cnt == 0)
+        list_remove (&a->elem);
+    }
+  lock_release (&d->lock);
+
+  return m->cnt > 0;
+}
+
+/* Moves CNT blocks from magazine M back to their arenas, freeing
+   any arena that becomes entirely unused. */
+static void
+mag_flush (struct desc *d, struct malloc_magazine *m, size_t cnt) 
+{
+  lock_acquire (&d->lock);
+  while (cnt-- > 0)
+    {
+      struct block *b = mag_pop (m);
+      struct arena *a = block_to_arena (b);
+
+      /* Add block to its arena's free list. */
+      if (a->free_cnt == 0)
+        list_push_back (&d->arenas, &a->elem);
+      b->next = a->free;
+      a->free = b;
+
+      /* If the arena is now entirely unused, free it. */
+      if (++a->free_cnt >= d->blocks_per_arena) 
+        {
+          ASSERT (a->free_cnt == d->blocks_per_arena);
+          list_remove (&a->elem);
+          d->arena_cnt--;
+          palloc_free_page (a);
+        }
+    }
+  lock_release (&d->lock);
+}
+
+/* Obtains a new arena for D, divides it into free blocks, and
+   adds it to D's list.  Returns the arena, or a null pointer if
+   no page is available.  D's lock must be held. */
+static struct arena *
+arena_create (struct desc *d) 
+{
+  struct arena *a;
+  size_t i;
+
+  a = palloc_get_page (0);
+  if (a == NULL)
+    return NULL;
+
+  a->magic = ARENA_MAGIC;
+  a->desc = d;
+  a->free_cnt = d->blocks_per_arena;
+  a->free = NULL;
+  for (i = d->blocks_per_arena; i-- > 0; )
+    {
+      struct block *b = arena_to_block (a, i);
+      b->next = a->free;
+      a->free = b;
+    }
+  list_push_back (&d->arenas, &a->elem);
+  d->arena_cnt++;
+
+  return a;
+}
+
+/* Prints, for each block size, the bytes in blocks in use and
+   the pages held in arenas for them, then the totals, including
+   big blocks.  Blocks cached in threads' magazines count as in
+   use.  Takes no locks, since it runs at shutdown. */
+void
+malloc_print_stats (void) 
+{
+  size_t used_bytes = 0, page_cnt = big_page_cnt;
+  struct desc *d;
+
+  for (d = descs; d < descs + desc_cnt; d++)
+    {
+      size_t block_cnt = d->arena_cnt * d->blocks_per_arena;
+      struct list_elem *e;
+
+      if (d->arena_cnt == 0)
+        continue;
+      for (e = list_begin (&d->arenas); e != list_end (&d->arenas);
+           e = list_next (e))
+        block_cnt -= list_entry (e, struct arena, elem)->free_cnt;
+      printf ("malloc: %zu-byte blocks: %zu bytes in use in %zu pages\n",
+              d->block_size, block_cnt * d->block_size, d->arena_cnt);
+      used_bytes += block_cnt * d->block_size;
+      page_cnt += d->arena_cnt;
+    }
+  printf ("malloc: %zu bytes in use, %zu pages held "
+          "(%zu in big blocks)\n",
+          used_bytes, page_cnt, big_page_cnt);
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b)
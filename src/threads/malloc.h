@@ -4,10 +4,22 @@
 #include <debug.h>
 #include <stddef.h>
 
+/* Number of block sizes that malloc() carves out of arenas. */
+#define MALLOC_CLASS_CNT 7
+
+/* A thread's private stack of free blocks of one size. */
+struct malloc_magazine
+  {
+    void *top;                  /* Most recently freed block. */
+    size_t cnt;                 /* Number of blocks. */
+  };
+
 void malloc_init (void);
+void malloc_thread_exit (void);
 void *malloc (size_t) __attribute__ ((malloc));
 void *calloc (size_t, size_t) __attribute__ ((malloc));
 void *realloc (void *, size_t);
 void free (void *);
+void malloc_print_stats (void);
 
 #endif /* threads/malloc.h */
@@ -7,8 +7,8 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
-#include "threads/synch.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -23,14 +23,61 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Most requests are for a single page, so each pool keeps up to
+   CACHE_MAX freed single pages on a stack, linked through the
+   pages themselves, and hands them out again in constant time.
+   Cached pages stay marked as used in the bitmap.  Other
+   requests, and single pages when the cache is empty, are served
+   from the bitmap, scanning from the lowest page that may be
+   free; if a multi-page request finds no room there, the cache
+   is emptied back into the bitmap and the scan retried.
+
+   The idle thread also keeps up to ZEROED_MAX free pages per
+   pool zeroed in advance (see palloc_prezero()), so that single
+   PAL_ZERO pages can usually be handed out without a memset.
+
+   A pool is protected by turning interrupts off rather than by a
+   lock, like a per-CPU cache, because thread_schedule_tail()
+   frees the page of a dying thread with interrupts off, where
+   it must not block. */
+
+/* Maximum number of free pages cached per pool. */
+#define CACHE_MAX 64
+
+/* Maximum number of pre-zeroed pages per pool. */
+#define ZEROED_MAX 32
+
+/* A free page in a pool's cache. */
+struct free_page
+  {
+    struct free_page *next;             /* Next cached page. */
+  };
 
 /* A memory pool. */
 struct pool
   {
-    struct lock lock;                   /* Mutual exclusion. */
     struct bitmap *used_map;            /* Bitmap of free pages. */
     uint8_t *base;                      /* Base of pool. */
+    const char *name;                   /* For statistics. */
+
+    struct free_page *cache;            /* Cached free pages. */
+    size_t cache_cnt;                   /* Number of cached pages. */
+    struct free_page *zeroed;           /* Free pages zeroed except
+                                           for their first word. */
+    size_t zeroed_cnt;                  /* Number of zeroed pages. */
+    size_t first_free;                  /* No free page in used_map
+                                           below this index. */
+
+    /* Statistics. */
+    size_t used_cnt;                    /* Pages handed out now. */
+    size_t high_water;                  /* Most ever handed out. */
+    long long cache_hits;               /* Pages from the cache. */
+    long long scans;                    /* Requests that scanned. */
+    long long drains;                   /* Times the cache was emptied. */
+    long long zero_hits;                /* PAL_ZERO from zeroed pages. */
+    long long zero_misses;              /* PAL_ZERO zeroed on demand. */
   };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -39,6 +86,11 @@ static struct pool kernel_pool, user_pool;
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
 static bool page_from_pool (const struct pool *, void *page);
+static size_t scan_pool (struct pool *, size_t page_cnt);
+static void release_to_map (struct pool *, size_t page_idx, size_t page_cnt);
+static void *pop_page (struct free_page **, size_t *cnt);
+static void drain (struct pool *, struct free_page **, size_t *cnt);
+static void print_pool_stats (struct pool *);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -71,24 +123,61 @@ void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 {
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-  void *pages;
+  void *pages = NULL;
+  bool zero = (flags & PAL_ZERO) != 0;
+  enum intr_level old_level;
   size_t page_idx;
 
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
-
-  if (page_idx != BITMAP_ERROR)
-    pages = pool->base + PGSIZE * page_idx;
-  else
-    pages = NULL;
+  old_level = intr_disable ();
+  if (page_cnt == 1) 
+    {
+      if (zero && pool->zeroed != NULL)
+        {
+          pages = pop_page (&pool->zeroed, &pool->zeroed_cnt);
+          zero = false;
+        }
+      else if (pool->cache != NULL)
+        {
+          pages = pop_page (&pool->cache, &pool->cache_cnt);
+          pool->cache_hits++;
+        }
+    }
+  if (pages == NULL) 
+    {
+      page_idx = scan_pool (pool, page_cnt);
+      if (page_idx == BITMAP_ERROR
+          && (pool->cache != NULL || pool->zeroed != NULL))
+        {
+          /* The caches may hold what we need to make a run. */
+          drain (pool, &pool->cache, &pool->cache_cnt);
+          drain (pool, &pool->zeroed, &pool->zeroed_cnt);
+          pool->drains++;
+          page_idx = scan_pool (pool, page_cnt);
+        }
+      if (page_idx != BITMAP_ERROR)
+        pages = pool->base + PGSIZE * page_idx;
+    }
+  if (pages != NULL)
+    {
+      pool->used_cnt += page_cnt;
+      if (pool->used_cnt > pool->high_water)
+        pool->high_water = pool->used_cnt;
+      if (flags & PAL_ZERO)
+        {
+          if (zero)
+            pool->zero_misses++;
+          else
+            pool->zero_hits++;
+        }
+    }
+  intr_set_level (old_level);
 
   if (pages != NULL) 
     {
-      if (flags & PAL_ZERO)
+      if (zero)
         memset (pages, 0, PGSIZE * page_cnt);
     }
   else 
@@ -118,6 +207,7 @@ void
 palloc_free_multiple (void *pages, size_t page_cnt) 
 {
   struct pool *pool;
+  enum intr_level old_level;
   size_t page_idx;
 
   ASSERT (pg_ofs (pages) == 0);
@@ -137,8 +227,24 @@ palloc_free_multiple (void *pages, size_t page_cnt)
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
+  old_level = intr_disable ();
   ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  pool->used_cnt -= page_cnt;
+  if (page_cnt == 1 && pool->cache_cnt < CACHE_MAX)
+    {
+      struct free_page *page = pages;
+#ifndef NDEBUG
+      struct free_page *p;
+      for (p = pool->cache; p != NULL; p = p->next)
+        ASSERT (p != page);
+#endif
+      page->next = pool->cache;
+      pool->cache = page;
+      pool->cache_cnt++;
+    }
+  else
+    release_to_map (pool, page_idx, page_cnt);
+  intr_set_level (old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -148,6 +254,58 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
+/* Zeroes one free page in advance for a later PAL_ZERO request,
+   if some pool has fewer than ZEROED_MAX such pages and a free
+   page to zero.  Returns true if it zeroed a page, false if
+   there was nothing to do.  Called by the idle thread, with
+   interrupts on; they stay on while the page is zeroed. */
+bool
+palloc_prezero (void) 
+{
+  struct pool *pools[] = {&kernel_pool, &user_pool};
+  struct free_page *page = NULL;
+  struct pool *pool = NULL;
+  enum intr_level old_level;
+  size_t i;
+
+  old_level = intr_disable ();
+  for (i = 0; i < sizeof pools / sizeof *pools && page == NULL; i++) 
+    {
+      pool = pools[i];
+      if (pool->zeroed_cnt >= ZEROED_MAX)
+        continue;
+      if (pool->cache != NULL)
+        page = pop_page (&pool->cache, &pool->cache_cnt);
+      else 
+        {
+          size_t page_idx = scan_pool (pool, 1);
+          if (page_idx != BITMAP_ERROR)
+            page = (struct free_page *) (pool->base + PGSIZE * page_idx);
+        }
+    }
+  intr_set_level (old_level);
+  if (page == NULL)
+    return false;
+
+  /* The page is neither free nor in use while we zero it. */
+  memset (page, 0, PGSIZE);
+
+  old_level = intr_disable ();
+  page->next = pool->zeroed;
+  pool->zeroed = page;
+  pool->zeroed_cnt++;
+  intr_set_level (old_level);
+  return true;
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void) 
+{
+  print_pool_stats (&kernel_pool);
+  print_pool_stats (&user_pool);
+}
+
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void
@@ -164,9 +322,103 @@ init_pool (struct pool *p, void *base, size_t page_cnt, const char *name)
   printf ("%zu pages available in %s.\n", page_cnt, name);
 
   /* Initialize the pool. */
-  lock_init (&p->lock);
   p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
   p->base = base + bm_pages * PGSIZE;
+  p->name = name;
+  p->cache = NULL;
+  p->cache_cnt = 0;
+  p->zeroed = NULL;
+  p->zeroed_cnt = 0;
+  p->first_free = 0;
+  p->used_cnt = p->high_water = 0;
+  p->cache_hits = p->scans = p->drains = 0;
+  p->zero_hits = p->zero_misses = 0;
+}
+
+/* Marks the first run of PAGE_CNT free pages in POOL's bitmap as
+   used and returns the index of its first page, or BITMAP_ERROR
+   if there is none.  Interrupts must be off. */
+static size_t
+scan_pool (struct pool *pool, size_t page_cnt) 
+{
+  size_t page_idx;
+
+  pool->scans++;
+  page_idx = bitmap_scan_and_flip (pool->used_map, pool->first_free,
+                                   page_cnt, false);
+  if (page_idx == pool->first_free)
+    pool->first_free += page_cnt;
+  return page_idx;
+}
+
+/* Marks the PAGE_CNT pages starting at PAGE_IDX free in POOL's
+   bitmap.  Interrupts must be off. */
+static void
+release_to_map (struct pool *pool, size_t page_idx, size_t page_cnt) 
+{
+  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  if (page_idx < pool->first_free)
+    pool->first_free = page_idx;
+}
+
+/* Removes and returns the first page on STACK, which holds *CNT
+   pages.  Interrupts must be off. */
+static void *
+pop_page (struct free_page **stack, size_t *cnt) 
+{
+  struct free_page *page = *stack;
+
+  *stack = page->next;
+  page->next = NULL;
+  (*cnt)--;
+  return page;
+}
+
+/* Returns all the pages on STACK, which holds *CNT pages, to
+   POOL's bitmap.  Interrupts must be off. */
+static void
+drain (struct pool *pool, struct free_page **stack, size_t *cnt) 
+{
+  while (*stack != NULL)
+    release_to_map (pool, pg_no (pop_page (stack, cnt))
+                          - pg_no (pool->base), 1);
+}
+
+/* Prints statistics for POOL: how many of its pages are in use,
+   the most that ever were, how requests were served, and how
+   its free pages are fragmented. */
+static void
+print_pool_stats (struct pool *pool) 
+{
+  struct pool copy;
+  size_t page_cnt = bitmap_size (pool->used_map);
+  size_t run_cnt = 0, largest = 0;
+  size_t start = 0;
+  enum intr_level old_level;
+
+  old_level = intr_disable ();
+  copy = *pool;
+  while ((start = bitmap_scan (pool->used_map, start, 1, false))
+         != BITMAP_ERROR) 
+    {
+      size_t end = bitmap_scan (pool->used_map, start, 1, true);
+      if (end == BITMAP_ERROR)
+        end = page_cnt;
+      if (end - start > largest)
+        largest = end - start;
+      run_cnt++;
+      start = end;
+    }
+  intr_set_level (old_level);
+
+  printf ("%s: %zu of %zu pages in use, %zu at most; "
+          "%lld cache hits, %lld scans, %lld drains; "
+          "%zu cached, %zu free runs, largest %zu; "
+          "PAL_ZERO: %lld pre-zeroed, %lld zeroed on demand\n",
+          copy.name, copy.used_cnt, page_cnt, copy.high_water,
+          copy.cache_hits, copy.scans, copy.drains,
+          copy.cache_cnt, run_cnt, largest,
+          copy.zero_hits, copy.zero_misses);
 }
 
 /* Returns true if PAGE was allocated from POOL,
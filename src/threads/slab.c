@@ -0,0 +1,256 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* A slab allocator for kernel objects of fixed size.
+
+   Each cache hands out objects of a single size.  It carves
+   pages, called "slabs", into as many objects as fit after a
+   small header, and keeps each slab on one of three lists
+   according to whether some, all, or none of its objects are in
+   use.  Allocation prefers a partially used slab, which keeps
+   live objects packed into few pages, then an empty one, and
+   only then gets a new page.  A cache holds on to at most one
+   empty slab and returns any others to the page allocator.
+
+   Unlike malloc(), which rounds every request up to a power of
+   2 and serializes each size on one lock, a cache packs objects
+   at their own size rounded up to a word and has its own lock.
+
+   A cache may have a constructor, which runs on every object of
+   a slab when the slab is created, instead of on every
+   allocation.  Objects in such a cache must be freed in their
+   constructed state.  Their free list link lives just past the
+   object rather than in its first word, so freeing one does not
+   disturb it. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab0bec
+
+/* Header at the start of each slab's page. */
+struct slab
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct slab_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in one of the cache's lists. */
+    void *free;                 /* First free object. */
+    size_t used_cnt;            /* Number of objects in use. */
+  };
+
+/* All initialized caches, for statistics. */
+static struct list all_caches;
+
+static struct slab *slab_create (struct slab_cache *);
+static struct slab *obj_to_slab (struct slab_cache *, void *);
+
+/* Initializes the slab allocator. */
+void
+slab_init (void)
+{
+  list_init (&all_caches);
+}
+
+/* Initializes cache C to hand out objects of SIZE bytes, named
+   NAME.  If CTOR is nonnull, it is run on each object once,
+   when the page holding the object is added to the cache. */
+void
+slab_cache_init (struct slab_cache *c, const char *name, size_t size,
+                 slab_ctor_func *ctor)
+{
+  ASSERT (c != NULL);
+  ASSERT (size > 0);
+
+  c->name = name;
+  c->obj_size = size;
+  c->ctor = ctor;
+  c->stride = ROUND_UP (size, sizeof (void *));
+  if (ctor != NULL)
+    {
+      c->link_ofs = c->stride;
+      c->stride += sizeof (void *);
+    }
+  else
+    c->link_ofs = 0;
+  c->objs_per_slab = (PGSIZE - sizeof (struct slab)) / c->stride;
+  ASSERT (c->objs_per_slab > 0);
+
+  lock_init (&c->lock);
+  list_init (&c->partial);
+  list_init (&c->full);
+  list_init (&c->empty);
+  c->slab_cnt = 0;
+  c->used_cnt = 0;
+  c->alloc_cnt = 0;
+  list_push_back (&all_caches, &c->elem);
+}
+
+/* Returns the free list link in object OBJ of cache C. */
+static void **
+obj_link (struct slab_cache *c, void *obj)
+{
+  return (void **) ((uint8_t *) obj + c->link_ofs);
+}
+
+/* Obtains and returns a new object from cache C.  Returns a null
+   pointer if memory is not available. */
+void *
+slab_alloc (struct slab_cache *c)
+{
+  struct slab *s;
+  void *obj;
+
+  lock_acquire (&c->lock);
+  if (!list_empty (&c->partial))
+    s = list_entry (list_front (&c->partial), struct slab, elem);
+  else
+    {
+      if (!list_empty (&c->empty))
+        s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+      else
+        {
+          s = slab_create (c);
+          if (s == NULL)
+            {
+              lock_release (&c->lock);
+              return NULL;
+            }
+        }
+      list_push_front (&c->partial, &s->elem);
+    }
+
+  /* Take the slab's first free object. */
+  obj = s->free;
+  s->free = *obj_link (c, obj);
+  if (++s->used_cnt == c->objs_per_slab)
+    {
+      list_remove (&s->elem);
+      list_push_front (&c->full, &s->elem);
+    }
+  c->used_cnt++;
+  c->alloc_cnt++;
+  lock_release (&c->lock);
+
+  return obj;
+}
+
+/* Frees object OBJ, which must have been obtained from cache C
+   with slab_alloc().  OBJ may be a null pointer. */
+void
+slab_free (struct slab_cache *c, void *obj)
+{
+  struct slab *s;
+
+  if (obj == NULL)
+    return;
+  s = obj_to_slab (c, obj);
+
+#ifndef NDEBUG
+  /* Clear the object to help detect use-after-free bugs, unless
+     it has to stay constructed. */
+  if (c->ctor == NULL)
+    memset (obj, 0xcc, c->obj_size);
+#endif
+
+  lock_acquire (&c->lock);
+  ASSERT (s->used_cnt > 0);
+  *obj_link (c, obj) = s->free;
+  s->free = obj;
+  c->used_cnt--;
+  if (s->used_cnt-- == c->objs_per_slab)
+    {
+      /* It was full. */
+      list_remove (&s->elem);
+      list_push_front (&c->partial, &s->elem);
+    }
+  if (s->used_cnt == 0)
+    {
+      list_remove (&s->elem);
+      if (list_empty (&c->empty))
+        list_push_front (&c->empty, &s->elem);
+      else
+        {
+          c->slab_cnt--;
+          s->magic = 0;
+          palloc_free_page (s);
+        }
+    }
+  lock_release (&c->lock);
+}
+
+/* Obtains a page for cache C and carves it into free objects.
+   Returns the new slab, or a null pointer if no page is
+   available.  The caller must hold C's lock and put the slab on
+   one of C's lists. */
+static struct slab *
+slab_create (struct slab_cache *c)
+{
+  struct slab *s;
+  uint8_t *obj;
+  size_t i;
+
+  s = palloc_get_page (0);
+  if (s == NULL)
+    return NULL;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = c;
+  s->used_cnt = 0;
+  s->free = NULL;
+
+  /* Thread the objects onto the free list from the last one
+     down, so that they are handed out in address order. */
+  obj = (uint8_t *) (s + 1) + c->objs_per_slab * c->stride;
+  for (i = 0; i < c->objs_per_slab; i++)
+    {
+      obj -= c->stride;
+      if (c->ctor != NULL)
+        c->ctor (obj);
+      *obj_link (c, obj) = s->free;
+      s->free = obj;
+    }
+  c->slab_cnt++;
+
+  return s;
+}
+
+/* Returns the slab that object OBJ of cache C is inside. */
+static struct slab *
+obj_to_slab (struct slab_cache *c, void *obj)
+{
+  struct slab *s = pg_round_down (obj);
+
+  /* Check that the slab is valid and belongs to C. */
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT (s->cache == c);
+
+  /* Check that the object is properly aligned for the slab. */
+  ASSERT ((pg_ofs (obj) - sizeof *s) % c->stride == 0);
+
+  return s;
+}
+
+/* Prints statistics for every cache.  The bytes reported as
+   wasted are those held in slabs but not requested by the
+   objects in use: free objects, padding, and slab headers.
+   Takes no locks, since it runs at shutdown. */
+void
+slab_print_stats (void)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&all_caches); e != list_end (&all_caches);
+       e = list_next (e))
+    {
+      struct slab_cache *c = list_entry (e, struct slab_cache, elem);
+      size_t waste = c->slab_cnt * PGSIZE - c->used_cnt * c->obj_size;
+
+      printf ("slab %s: %lld allocs, %zu in use, %zu slabs, "
+              "%zu bytes wasted\n",
+              c->name, c->alloc_cnt, c->used_cnt, c->slab_cnt, waste);
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+#include "threads/synch.h"
+
+/* Initializes a newly carved object. */
+typedef void slab_ctor_func (void *obj);
+
+/* A cache of objects of one size. */
+struct slab_cache
+  {
+    const char *name;           /* Name, for statistics. */
+    size_t obj_size;            /* Size of each object in bytes. */
+    size_t stride;              /* Bytes between consecutive objects. */
+    size_t link_ofs;            /* Offset of free list link in object. */
+    size_t objs_per_slab;       /* Number of objects in a slab. */
+    slab_ctor_func *ctor;       /* Constructor, or null. */
+    struct lock lock;           /* Protects the lists and counts. */
+    struct list partial;        /* Slabs with used and free objects. */
+    struct list full;           /* Slabs with no free objects. */
+    struct list empty;          /* Slabs with no used objects. */
+    size_t slab_cnt;            /* Number of slabs in all lists. */
+    size_t used_cnt;            /* Number of objects in use. */
+    long long alloc_cnt;        /* Number of allocations. */
+    struct list_elem elem;      /* Element in list of all caches. */
+  };
+
+void slab_init (void);
+void slab_cache_init (struct slab_cache *, const char *name, size_t size,
+                      slab_ctor_func *);
+void *slab_alloc (struct slab_cache *);
+void slab_free (struct slab_cache *, void *);
+void slab_print_stats (void);
+
+#endif /* threads/slab.h */
@@ -29,6 +29,7 @@
 #include "threads/synch.h"
 #include <stdio.h>
 #include <string.h>
+#include "devices/timer.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 
@@ -115,6 +116,52 @@ sema_try_down (struct semaphore *sema)
   return success;
 }
 
+/* Down or "P" operation on a semaphore, giving up if SEMA is
+   still 0 after TICKS timer ticks.  Returns true if the
+   semaphore was decremented, false if the time ran out.
+
+   The waiting thread stays on SEMA's waiters like in sema_down(),
+   with its deadline in wake_tick.  If the deadline passes first,
+   thread_on_tick() takes it off the waiters and unblocks it, so
+   sema_up() only ever finds blocked threads there.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler.  This function may be called with
+   interrupts disabled, but if it sleeps then the next scheduled
+   thread will probably turn interrupts back on. */
+bool
+sema_down_timeout (struct semaphore *sema, int64_t ticks) 
+{
+  int64_t start = timer_ticks ();
+  enum intr_level old_level;
+  bool success = true;
+
+  ASSERT (sema != NULL);
+  ASSERT (!intr_context ());
+
+  old_level = intr_disable ();
+  while (sema->value == 0) 
+    {
+      struct thread *t = thread_current ();
+
+      if (timer_elapsed (start) >= ticks)
+        {
+          success = false;
+          break;
+        }
+      t->is_waiting = 1;
+      t->wake_tick = start + ticks;
+      list_push_back (&sema->waiters, &t->elem);
+      thread_block ();
+      t->wake_tick = 0;
+    }
+  if (success)
+    sema->value--;
+  intr_set_level (old_level);
+
+  return success;
+}
+
 /* Up or "V" operation on a semaphore.  Increments SEMA's value
    and wakes up one thread of those waiting for SEMA, if any.
 
@@ -85,6 +85,7 @@ static void thread_update_lock(struct thread *t, struct lock *lock, struct threa
 static int thread_get_max_inherit_priority(struct thread *t);
 
 static void thread_init_priority_queue(void);
+static bool thread_any_ready(void);
 
 //static 
 void thread_calc_rcpu(struct thread *t);
@@ -288,7 +289,17 @@ void thread_on_tick(struct thread *t, void *aux)
         thread_calc_rcpu(t);
     if(t->status == THREAD_BLOCKED)
     {
-        if(t->sleep_time > 0)
+        if(t->wake_tick > 0 && ticks >= t->wake_tick)
+        {
+            /* Timed out in sema_down_timeout(): take it off the
+               semaphore's waiters before its elem joins the ready
+               queue. */
+            list_remove(&t->elem);
+            t->wake_tick = 0;
+            t->is_waiting = 0;
+            thread_unblock(t);
+        }
+        else if(t->sleep_time > 0)
             t->sleep_time--;
         else if(t->is_waiting == 0)
             thread_unblock(t);
@@ -351,6 +362,7 @@ thread_exit (void)
 #ifdef USERPROG
   process_destroy();
 #endif
+  malloc_thread_exit ();
   list_remove (&thread_current()->allelem);
   thread_current ()->status = THREAD_DYING;
   schedule ();
@@ -534,8 +546,21 @@ idle (void *idle_started_ UNUSED)
 
   for (;;) 
     {
-      /* Let someone else run. */
+      /* Zero free pages for later PAL_ZERO allocations while
+         nobody else wants the CPU. */
       intr_disable ();
+      while (!thread_any_ready ())
+        {
+          bool zeroed;
+
+          intr_enable ();
+          zeroed = palloc_prezero ();
+          intr_disable ();
+          if (!zeroed)
+            break;
+        }
+
+      /* Let someone else run. */
       thread_block ();
 
       /* Re-enable interrupts and wait for the next one.
@@ -744,6 +769,20 @@ void thread_push_to_priority_queue(struct thread *t)
     list_push_back (&priority_queue[priority - PRI_MIN], &t->elem);
 }
 
+/* Returns true if any thread is ready to run, checking the
+   highest priorities first. */
+static bool thread_any_ready()
+{
+    int index;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    for(index = PRI_MAX - PRI_MIN; index >= 0; --index)
+        if(!list_empty(&priority_queue[index]))
+            return true;
+    return false;
+}
+
 struct thread* thread_pop_from_priority_queue()
 {
     struct thread *t = NULL;
@@ -4,7 +4,9 @@
 #include <debug.h>
 #include <list.h>
 #include <stdint.h>
+#include "threads/malloc.h"
 #ifdef USERPROG
+#include <ihash.h>
 #include "threads/synch.h"
 #include "filesys/fd.h"
 #endif
@@ -45,8 +47,9 @@ struct thread_lock
 struct process_child_node
 {
     struct lock lock;
-    struct condition cond;
-    struct list list;
+    struct semaphore exit_sema;  /* Upped whenever a child exits. */
+    struct ihash hash;           /* Children not yet waited for, by tid. */
+    struct list exited;          /* Those that have exited, in order. */
     tid_t ptid;
 };
 
@@ -55,6 +58,7 @@ struct process
     struct process_child_node childs;
     struct fd_node fd_node;
     struct file *exe;
+    struct ring *ring;          /* User's system call ring, if any. */
 };
 
 #endif
@@ -126,6 +130,7 @@ struct thread
     
     int64_t sleep_time;                  /* Maintains the sleep time. */    
     int is_waiting;                     /* Check if the thread is waiting or not. */
+    int64_t wake_tick;                  /* Tick at which a timed semaphore wait gives up, or 0. */
     int saved_priority;                 /* This will be use in case of priority inversion, it will restore the original priority. */
     
     struct thread *parent_thread;                   /* Parent thread on which it is blocked. */
@@ -138,11 +143,18 @@ struct thread
     
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;              /* List element. */
+
+    /* Owned by malloc.c. */
+    struct malloc_magazine magazines[MALLOC_CLASS_CNT];
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
     struct process *proc;
 #endif
+#ifdef VM
+    /* Owned by vm/page.c. */
+    struct hash *pages;                 /* Supplemental page table. */
+#endif
 
 /* Used for mlfq. */
     int nice;                       /* Current nice value for thread. */
@@ -1,15 +1,46 @@
 #include "userprog/exception.h"
+#include <cpu.h>
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
 #include "userprog/process.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
 
+#ifdef VM
+/* Resolved page faults, by type, and a histogram of the time
+   each took to resolve.  Bucket I counts faults that took
+   between 2**I and 2**(I+1) - 1 TSC cycles. */
+#define FAULT_BUCKETS 32
+static long long fault_type_cnt[FAULT_TYPE_CNT];
+static unsigned fault_hist[FAULT_TYPE_CNT][FAULT_BUCKETS];
+static const char *fault_type_names[FAULT_TYPE_CNT] =
+  {"zero", "file", "stack", "COW"};
+
+static void fault_record (enum page_fault_type, uint64_t cycles);
+#endif
+
+/* An exception table entry: an instruction that may fault on a
+   user address, and where to resume if it does.  The linker
+   script gathers the entries made by EXCEPTION_ENTRY between
+   these two symbols. */
+struct exception_entry
+  {
+    uintptr_t insn;
+    uintptr_t fixup;
+  };
+extern const struct exception_entry _start_ex_table[], _end_ex_table[];
+
 static void kill (struct intr_frame *);
+static void debug_exception (struct intr_frame *);
 static void page_fault (struct intr_frame *);
 
 /* Registers handlers for interrupts that can be caused by user
@@ -44,7 +75,7 @@ exception_init (void)
      caused indirectly, e.g. #DE can be caused by dividing by
      0.  */
   intr_register_int (0, 0, INTR_ON, kill, "#DE Divide Error");
-  intr_register_int (1, 0, INTR_ON, kill, "#DB Debug Exception");
+  intr_register_int (1, 0, INTR_ON, debug_exception, "#DB Debug Exception");
   intr_register_int (6, 0, INTR_ON, kill, "#UD Invalid Opcode Exception");
   intr_register_int (7, 0, INTR_ON, kill,
                      "#NM Device Not Available Exception");
@@ -66,8 +97,43 @@ void
 exception_print_stats (void) 
 {
   printf ("Exception: %lld page faults\n", page_fault_cnt);
+#ifdef VM
+  {
+    int type, i;
+
+    for (type = 0; type < FAULT_TYPE_CNT; type++) 
+      {
+        if (fault_type_cnt[type] == 0)
+          continue;
+        printf ("  %lld %s faults, cycles by log2:", fault_type_cnt[type],
+                fault_type_names[type]);
+        for (i = 0; i < FAULT_BUCKETS; i++)
+          if (fault_hist[type][i] != 0)
+            printf (" %d:%u", i, fault_hist[type][i]);
+        printf ("\n");
+      }
+  }
+#endif
 }
 
+#ifdef VM
+/* Records a page fault of the given TYPE that was resolved in
+   CYCLES TSC cycles. */
+static void
+fault_record (enum page_fault_type type, uint64_t cycles) 
+{
+  int bucket = 0;
+
+  while (cycles > 1 && bucket < FAULT_BUCKETS - 1)
+    {
+      cycles >>= 1;
+      bucket++;
+    }
+  fault_type_cnt[type]++;
+  fault_hist[type][bucket]++;
+}
+#endif
+
 /* Handler for an exception (probably) caused by a user process. */
 static void
 kill (struct intr_frame *f) 
@@ -111,6 +177,22 @@ kill (struct intr_frame *f)
     }
 }
 
+/* Debug exception handler.  SYSENTER does not clear the trap
+   flag, so a user program that sets it and then makes a fast
+   system call takes a single-step trap on the first instruction
+   of sysenter_entry.  Clear the flag and carry on; anything else
+   is handled like the other exceptions. */
+static void
+debug_exception (struct intr_frame *f) 
+{
+  if (f->cs == SEL_KCSEG && (f->eflags & FLAG_TF) != 0)
+    {
+      f->eflags &= ~FLAG_TF;
+      return;
+    }
+  kill (f);
+}
+
 /* Page fault handler.  This is a skeleton that must be filled in
    to implement virtual memory.  Some solutions to project 2 may
    also require modifying this code.
@@ -129,6 +211,10 @@ page_fault (struct intr_frame *f)
   bool write;        /* True: access was write, false: access was read. */
   bool user;         /* True: access by user, false: access by kernel. */
   void *fault_addr;  /* Fault address. */
+#ifdef VM
+  uint64_t start = rdtsc ();
+  enum page_fault_type type;
+#endif
 
   /* Obtain faulting address, the virtual address that was
      accessed to cause the fault.  It may point to code or to
@@ -151,6 +237,33 @@ page_fault (struct intr_frame *f)
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
+#ifdef VM
+  /* Bring in pages that the process owns but that have not been
+     mapped yet.  The kernel can fault on these too, when a
+     system call touches a user buffer. */
+  if (page_fault_in (fault_addr, not_present, write, &type))
+    {
+      fault_record (type, rdtsc () - start);
+      return;
+    }
+#endif
+
+  /* A fault in the kernel on a user address from one of the user
+     memory accessors in userprog/syscall.c resumes at the
+     accessor's fixup address, with -1 in EAX. */
+  if (!user && is_user_vaddr (fault_addr))
+    {
+      const struct exception_entry *e;
+
+      for (e = _start_ex_table; e < _end_ex_table; e++)
+        if (e->insn == (uintptr_t) f->eip)
+          {
+            f->eip = (void (*) (void)) e->fixup;
+            f->eax = 0xffffffff;
+            return;
+          }
+    }
+
   /* To implement virtual memory, delete the rest of the function
      body, and replace it with code that brings in the page to
      which fault_addr refers. */
@@ -6,6 +6,15 @@
 #define PF_W 0x2    /* 0: read, 1: write. */
 #define PF_U 0x4    /* 0: kernel, 1: user process. */
 
+/* Emits an exception table entry from inside an asm statement.
+   If the instruction at label INSN faults on a user address,
+   page_fault() resumes at label FIXUP with -1 in EAX.  Any other
+   kernel fault is a bug. */
+#define EXCEPTION_ENTRY(INSN, FIXUP)                            \
+        ".pushsection .ex_table, \"a\"; "                       \
+        ".long " INSN ", " FIXUP "; "                           \
+        ".popsection; "
+
 void exception_init (void);
 void exception_print_stats (void);
 
@@ -0,0 +1,189 @@
+#include "userprog/image.h"
+#include <debug.h>
+#include <list.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+
+/* Executable image cache.
+
+   Loading a program reads and checks its ELF header and every
+   program header before it maps a single page.  Programs tend
+   to be run again and again, so we remember the result for the
+   last few executables, keyed by inode, and load() can go
+   straight to mapping the segments.
+
+   Each entry keeps its inode open, so that the in-memory inode,
+   and with it the inode's identity, lives as long as the entry.
+   An entry records the inode's version (see inode_get_version())
+   when it was made, and is not used once the inode has been
+   written since.  Holding a removed executable open would keep
+   its sectors allocated, so removed inodes are never cached and
+   their entries are dropped as soon as the cache is next used,
+   and by image_drop_removed() right after a removal. */
+
+/* Number of executables to remember. */
+#define IMAGE_CNT 8
+
+/* A cached image. */
+struct image_entry
+  {
+    struct list_elem elem;      /* Element in `images'. */
+    struct inode *inode;        /* Executable, kept open. */
+    unsigned version;           /* Inode version when cached. */
+    struct image *image;        /* Parsed headers. */
+  };
+
+static struct list images;      /* Cached images, most recent first. */
+static struct lock image_lock;  /* Protects `images'. */
+
+static long long hit_cnt;       /* Number of image_get() hits. */
+static long long miss_cnt;      /* Number of image_get() misses. */
+
+static struct image_entry *lookup (struct inode *);
+static void evict (struct image_entry *);
+static void evict_removed (void);
+
+/* Initializes the image cache. */
+void
+image_init (void)
+{
+  list_init (&images);
+  lock_init (&image_lock);
+}
+
+/* If INODE's image is cached and INODE has not been written
+   since, returns a copy of it, which the caller must free().
+   Otherwise, or if memory is not available, returns a null
+   pointer. */
+struct image *
+image_get (struct inode *inode)
+{
+  struct image_entry *e;
+  struct image *image = NULL;
+
+  lock_acquire (&image_lock);
+  evict_removed ();
+  e = lookup (inode);
+  if (e != NULL && e->version != inode_get_version (inode))
+    {
+      evict (e);
+      e = NULL;
+    }
+  if (e != NULL)
+    {
+      size_t size = IMAGE_SIZE (e->image->seg_cnt);
+      image = malloc (size);
+      if (image != NULL)
+        memcpy (image, e->image, size);
+    }
+  if (image != NULL)
+    hit_cnt++;
+  else
+    miss_cnt++;
+  lock_release (&image_lock);
+
+  return image;
+}
+
+/* Caches a copy of IMAGE as the image of INODE, replacing any
+   earlier one and, if the cache is full, the least recently
+   used.  Does nothing if IMAGE has more than IMAGE_SEG_MAX
+   segments. */
+void
+image_put (struct inode *inode, const struct image *image)
+{
+  struct image_entry *e;
+  size_t size = IMAGE_SIZE (image->seg_cnt);
+
+  if (image->seg_cnt > IMAGE_SEG_MAX || inode_is_removed (inode))
+    return;
+  e = malloc (sizeof *e);
+  if (e == NULL)
+    return;
+  e->image = malloc (size);
+  if (e->image == NULL)
+    {
+      free (e);
+      return;
+    }
+  memcpy (e->image, image, size);
+  e->inode = inode_reopen (inode);
+  e->version = inode_get_version (inode);
+
+  lock_acquire (&image_lock);
+  evict_removed ();
+  if (lookup (inode) != NULL)
+    evict (lookup (inode));
+  else if (list_size (&images) >= IMAGE_CNT)
+    evict (list_entry (list_back (&images), struct image_entry, elem));
+  list_push_front (&images, &e->elem);
+  lock_release (&image_lock);
+}
+
+/* Drops the entries of executables that have been removed, so
+   that their inodes can be closed and their sectors freed. */
+void
+image_drop_removed (void)
+{
+  lock_acquire (&image_lock);
+  evict_removed ();
+  lock_release (&image_lock);
+}
+
+/* Prints image cache statistics. */
+void
+image_print_stats (void)
+{
+  printf ("Exec images: %lld hits, %lld misses\n", hit_cnt, miss_cnt);
+}
+
+/* Returns the entry for INODE, moved to the front of `images',
+   or a null pointer if there is none.  The caller must hold
+   image_lock. */
+static struct image_entry *
+lookup (struct inode *inode)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&images); e != list_end (&images); e = list_next (e))
+    {
+      struct image_entry *ie = list_entry (e, struct image_entry, elem);
+      if (ie->inode == inode)
+        {
+          list_remove (e);
+          list_push_front (&images, e);
+          return ie;
+        }
+    }
+  return NULL;
+}
+
+/* Removes E from the cache and frees it.  The caller must hold
+   image_lock. */
+static void
+evict (struct image_entry *e)
+{
+  list_remove (&e->elem);
+  inode_close (e->inode);
+  free (e->image);
+  free (e);
+}
+
+/* Removes the entries whose inodes have been removed.  The
+   caller must hold image_lock. */
+static void
+evict_removed (void)
+{
+  struct list_elem *e, *next;
+
+  for (e = list_begin (&images); e != list_end (&images); e = next)
+    {
+      struct image_entry *ie = list_entry (e, struct image_entry, elem);
+      next = list_next (e);
+      if (inode_is_removed (ie->inode))
+        evict (ie);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef USERPROG_IMAGE_H
+#define USERPROG_IMAGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+
+struct inode;
+
+/* Maximum number of loadable segments in a cached image.
+   Executables with more are loaded but not cached. */
+#define IMAGE_SEG_MAX 8
+
+/* A loadable segment, as load_segment() in userprog/process.c
+   takes it. */
+struct image_segment
+  {
+    off_t ofs;                  /* Page-aligned offset in the file. */
+    uint8_t *upage;             /* Page-aligned user address. */
+    uint32_t read_bytes;        /* Bytes to read from the file. */
+    uint32_t zero_bytes;        /* Bytes to zero after them. */
+    bool writable;              /* Writable by the user? */
+  };
+
+/* What load() learns from an executable's ELF headers. */
+struct image
+  {
+    void (*entry) (void);       /* Entry point. */
+    size_t seg_cnt;             /* Number of segments. */
+    struct image_segment segs[]; /* SEG_CNT segments. */
+  };
+
+/* Size in bytes of a struct image with SEG_CNT segments. */
+#define IMAGE_SIZE(SEG_CNT) \
+        (sizeof (struct image) + (SEG_CNT) * sizeof (struct image_segment))
+
+void image_init (void);
+struct image *image_get (struct inode *);
+void image_put (struct inode *, const struct image *);
+void image_drop_removed (void);
+void image_print_stats (void);
+
+#endif /* userprog/image.h */
@@ -5,9 +5,13 @@
 #include "threads/init.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
+#ifdef VM
+#include "vm/frame.h"
+#endif
 
 static uint32_t *active_pd (void);
 static void invalidate_pagedir (uint32_t *);
+static uint32_t *lookup_page (uint32_t *pd, const void *vaddr, bool create);
 
 /* Creates a new page directory that has mappings for kernel
    virtual addresses, but none for user virtual addresses.
@@ -41,12 +45,75 @@ pagedir_destroy (uint32_t *pd)
         
         for (pte = pt; pte < pt + PGSIZE / sizeof *pte; pte++)
           if (*pte & PTE_P) 
+#ifdef VM
+            frame_release (pte_get_page (*pte));
+#else
             palloc_free_page (pte_get_page (*pte));
+#endif
         palloc_free_page (pt);
       }
   palloc_free_page (pd);
 }
 
+#ifdef VM
+/* Creates and returns a copy of the user mappings in page
+   directory PD, for a child process created by fork.  Rather
+   than copying any user pages, the copy maps the very same
+   frames, and every writable mapping, in both PD and the copy,
+   is made read-only and marked copy-on-write, so that the first
+   write to such a page by either process gives that process its
+   own copy (see page_fault_in()).  The cost is thus proportional
+   to the size of PD's page tables, not to the memory it maps.
+   Returns a null pointer if memory allocation fails. */
+uint32_t *
+pagedir_clone (uint32_t *pd) 
+{
+  uint32_t *copy = pagedir_create ();
+  uint32_t *pde;
+
+  if (copy == NULL)
+    return NULL;
+
+  for (pde = pd; pde < pd + pd_no (PHYS_BASE); pde++)
+    if (*pde & PTE_P) 
+      {
+        uint32_t *pt = pde_get_pt (*pde);
+        uint32_t *copy_pt = palloc_get_page (PAL_ZERO);
+        size_t i;
+
+        if (copy_pt == NULL)
+          {
+            pagedir_destroy (copy);
+            return NULL;
+          }
+        copy[pde - pd] = pde_create (copy_pt);
+
+        for (i = 0; i < PGSIZE / sizeof *pt; i++)
+          if (pt[i] & PTE_P)
+            {
+              if (pt[i] & PTE_W)
+                pt[i] = (pt[i] & ~(uint32_t) PTE_W) | PTE_COW;
+              frame_ref (pte_get_page (pt[i]));
+              copy_pt[i] = pt[i];
+            }
+      }
+
+  /* We just write-protected pages that PD may have cached in
+     the TLB as writable. */
+  invalidate_pagedir (pd);
+  return copy;
+}
+
+/* Returns true if virtual page VPAGE is mapped copy-on-write in
+   PD, false otherwise. */
+bool
+pagedir_is_cow (uint32_t *pd, const void *vpage) 
+{
+  uint32_t *pte = lookup_page (pd, vpage, false);
+  return pte != NULL && (*pte & (PTE_P | PTE_COW)) == (PTE_P | PTE_COW);
+}
+#endif
+
 /* Returns the address of the page table entry for virtual
    address VADDR in page directory PD.
    If PD does not have a page table for VADDR, behavior depends
@@ -14,5 +14,9 @@ void pagedir_set_dirty (uint32_t *pd, const void *upage, bool dirty);
 bool pagedir_is_accessed (uint32_t *pd, const void *upage);
 void pagedir_set_accessed (uint32_t *pd, const void *upage, bool accessed);
 void pagedir_activate (uint32_t *pd);
+#ifdef VM
+uint32_t *pagedir_clone (uint32_t *pd);
+bool pagedir_is_cow (uint32_t *pd, const void *upage);
+#endif
 
 #endif /* userprog/pagedir.h */
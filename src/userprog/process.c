@@ -2,12 +2,15 @@
 #include <debug.h>
 #include <inttypes.h>
 #include <round.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "userprog/gdt.h"
+#include "userprog/image.h"
 #include "userprog/pagedir.h"
 #include "userprog/tss.h"
+#include "devices/timer.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
@@ -16,27 +19,70 @@
 #include "threads/interrupt.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "threads/synch.h"
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/page.h"
+#endif
 
 struct spawn_node
 {
-    struct semaphore *sema;
-    char *arg_page;
-    char *args;
+    struct semaphore sema;      /* Constructed by spawn_node_ctor. */
+    bool sync;                  /* Whether the parent waits on SEMA. */
+    struct process_args *args;
+    struct process *parent;     /* To copy descriptors from, or NULL. */
     tid_t ptid;
     tid_t tid;
 };
 
+/* Arguments for a new process, in one page.  Each argument is
+   stored null-terminated in STRINGS, in order but with possibly
+   some bytes between one and the next, and the offset in STRINGS
+   of argument I is stored in the (I+1)'th word from the end of
+   the page.  push_args() can thus copy them all onto the new
+   process's stack at once. */
+struct process_args
+{
+    int argc;
+    size_t len;                 /* Bytes used in STRINGS. */
+    char strings[];
+};
+
+/* Bytes of a process_args page kept free for what push_args()
+   pushes besides the strings and their addresses: the null
+   argv[argc], argv, argc, the return address and alignment. */
+#define ARGS_SLACK 32
+
 struct child_node
 {
     tid_t tid;
-    int *status;
-    struct list_elem elem;
+    bool exited;
+    int status;
+    struct list_elem elem;          /* In its exited list, once exited. */
+};
+
+#ifdef VM
+/* Hands the parent's user state to a child being forked, and
+   the outcome back. */
+struct fork_node
+{
+    struct intr_frame if_;
+    struct thread *parent;
+    struct semaphore sema;
+    bool success;
 };
+#endif
+
+/* Caches of the objects above, and of `struct process'. */
+static struct slab_cache process_cache;
+static struct slab_cache spawn_cache;
+static struct slab_cache child_cache;
 
 /* Function related to exec. */
+static void spawn_node_ctor(void *snode_);
 static struct spawn_node* spawn_node_alloc(bool sync);
 static void spawn_node_free(struct spawn_node *snode);
 inline bool spawn_node_is_sync_set(struct spawn_node *snode);
@@ -45,14 +91,26 @@ inline static void spawn_node_awake(struct spawn_node *snode);
 
 /* Function related to wait. */
 static void process_insert_child(tid_t ctid);
-static void process_remove_child(struct child_node *child);
+static void process_remove_child(struct process_child_node *childs,
+                                 struct child_node *child);
 static struct child_node* process_search_child(struct process_child_node *child_node, tid_t tid);
+static ihash_action_func child_free;
+
+/* Function related to arguments. */
+static uint32_t* args_ofs(struct process_args *args);
+static size_t args_room(const struct process_args *args);
 
-static tid_t process_execute_(const char *file_name, bool sync);
+static tid_t process_execute_(struct process_args *args,
+                              struct process *parent, bool sync);
 
 static thread_func start_process NO_RETURN;
+#ifdef VM
+static thread_func fork_process NO_RETURN;
+static bool process_copy(struct process *parent);
+#endif
+static struct file* process_dup_file(struct file *file);
 static bool load (const char* file_name, void (**eip) (void), void **esp);
-static char* push_args(char *src, char *dest);
+static void* push_args(struct process_args *args, void *esp);
 
 /* Starts a new thread running a user program loaded from
    FILENAME.  The new thread may be scheduled (and may even exit)
@@ -60,20 +118,25 @@ static char* push_args(char *src, char *dest);
    thread id, or TID_ERROR if the thread cannot be created. */
 
 
+/* Sets up the semaphore in a spawn node.  Every down on it is
+   matched by an up, so a node goes back to its cache with the
+   semaphore still at 0 and needs no setting up the next time. */
+static void
+spawn_node_ctor(void *snode_)
+{
+    struct spawn_node *snode = snode_;
+    sema_init(&snode->sema, 0);
+}
+
 static struct spawn_node*
 spawn_node_alloc(bool sync)
 {
     struct spawn_node *snode;
-    snode = (struct spawn_node *)malloc(sizeof(struct spawn_node));
-    snode->ptid = thread_current()->tid;
+    snode = slab_alloc(&spawn_cache);
     if(snode)
     {
-        if(sync)
-        {
-            snode->sema = malloc(sizeof(struct semaphore));
-            sema_init(snode->sema, 0);
-        }
-        else snode->sema = NULL;
+        snode->ptid = thread_current()->tid;
+        snode->sync = sync;
     }
     return snode;
 }
@@ -81,65 +144,165 @@ spawn_node_alloc(bool sync)
 static void
 spawn_node_free(struct spawn_node *snode)
 {
-    if(snode->sema)
-        free(snode->sema);
-    free(snode);
+    ASSERT(snode->sema.value == 0);
+    slab_free(&spawn_cache, snode);
 }
 
 inline bool spawn_node_is_sync_set(struct spawn_node *snode)
 {
-    return snode->sema != NULL;
+    return snode->sync;
 }
 
 inline static void
 spawn_node_wait(struct spawn_node *snode)
 {
-    sema_down(snode->sema);
+    sema_down(&snode->sema);
 }
 
 inline static void
 spawn_node_awake(struct spawn_node *snode)
 {
-    sema_up(snode->sema);
+    sema_up(&snode->sema);
+}
+
+/* Returns the end of the offsets in ARGS. */
+static uint32_t*
+args_ofs(struct process_args *args)
+{
+    return (uint32_t*)((uint8_t*)args + PGSIZE);
+}
+
+/* Returns the number of bytes free in ARGS. */
+static size_t
+args_room(const struct process_args *args)
+{
+    size_t used = offsetof(struct process_args, strings) + args->len
+                  + args->argc * sizeof(uint32_t) + ARGS_SLACK;
+    return used < PGSIZE ? PGSIZE - used : 0;
+}
+
+/* Returns a new, empty set of arguments, or a null pointer if
+   memory cannot be allocated. */
+struct process_args*
+process_args_create(void)
+{
+    struct process_args *args = palloc_get_page(0);
+    if(args)
+    {
+        args->argc = 0;
+        args->len = 0;
+    }
+    return args;
+}
+
+void
+process_args_destroy(struct process_args *args)
+{
+    palloc_free_page(args);
+}
+
+/* Returns where the next argument goes in ARGS and stores in
+   *ROOM how many bytes, counting the null terminator, it may
+   take.  Returns a null pointer if ARGS is full. */
+char*
+process_args_next(struct process_args *args, size_t *room)
+{
+    size_t avail = args_room(args);
+    if(avail <= sizeof(uint32_t) + 1)
+        return NULL;
+    *room = avail - sizeof(uint32_t);
+    return args->strings + args->len;
+}
+
+/* Adds the LEN-byte string just written at process_args_next()
+   to ARGS as the next argument. */
+void
+process_args_add(struct process_args *args, size_t len)
+{
+    args_ofs(args)[-1 - args->argc++] = args->len;
+    args->len += len + 1;
+}
+
+/* Splits the string just written at process_args_next() at
+   spaces and adds each word to ARGS as an argument.  Returns
+   false if there is no word or no room for all of them. */
+bool
+process_args_split(struct process_args *args)
+{
+    char *str = args->strings + args->len;
+    char *token, *save_ptr;
+
+    args->len += strlen(str) + 1;
+    for(token = strtok_r(str, " ", &save_ptr); token != NULL;
+        token = strtok_r(NULL, " ", &save_ptr))
+    {
+        if(args_room(args) < sizeof(uint32_t))
+            return false;
+        args_ofs(args)[-1 - args->argc++] = token - args->strings;
+    }
+    return args->argc > 0;
 }
 
 tid_t
 process_execute(const char *file_name)
 {
-    return process_execute_(file_name, false);
+    struct process_args *args;
+    size_t room;
+    char *dst;
+
+    /* Make a copy of FILE_NAME.
+       Otherwise there's a race between the caller and load(). */
+    args = process_args_create();
+    if(!args)
+        return TID_ERROR;
+    dst = process_args_next(args, &room);
+    strlcpy(dst, file_name, room);
+    if(!process_args_split(args))
+    {
+        process_args_destroy(args);
+        return TID_ERROR;
+    }
+    return process_execute_(args, NULL, false);
 }
 
+/* Starts a process running the program named by the first of
+   ARGS, with ARGS as its arguments, and waits until it has
+   loaded.  If INHERIT_FDS is true the child starts with its own
+   handle on each file we have open, under the same descriptor.
+   Takes ownership of ARGS.  Returns the new process's thread id,
+   or TID_ERROR if it could not be started. */
 tid_t
-process_execute_sync(const char *file_name)
+process_spawn(struct process_args *args, bool inherit_fds)
 {
-    return process_execute_(file_name, true);
+    return process_execute_(args,
+                            inherit_fds ? thread_current()->proc : NULL,
+                            true);
 }
 
 static tid_t
-process_execute_(const char *file_name, bool sync)
+process_execute_(struct process_args *args, struct process *parent,
+                 bool sync)
 {
-  char *fn_copy;
-  char *proc_name;
   tid_t tid;
 
   struct spawn_node *snode = spawn_node_alloc(sync);
+  if (snode == NULL)
+    {
+      process_args_destroy (args);
+      return TID_ERROR;
+    }
 
-  /* Make a copy of FILE_NAME.
-     Otherwise there's a race between the caller and load(). */
-  fn_copy = palloc_get_page (0);
-  if (fn_copy == NULL)
-    return TID_ERROR;
-
-  snode->arg_page = fn_copy;
-
-  strlcpy(fn_copy, file_name, PGSIZE);
-  proc_name = strtok_r(fn_copy, " ", &fn_copy);
-  snode->args = fn_copy;
+  snode->args = args;
+  snode->parent = parent;
 
   /* Create a new thread to execute FILE_NAME. */
-  tid = thread_create (proc_name, PRI_DEFAULT, start_process, snode);
+  tid = thread_create (args->strings + args_ofs(args)[-1], PRI_DEFAULT,
+                       start_process, snode);
   if (tid == TID_ERROR)
-      palloc_free_page (fn_copy);
+    {
+      process_args_destroy (args);
+      spawn_node_free (snode);
+    }
    else
    {
        process_insert_child(tid);
@@ -159,8 +322,9 @@ process_execute_(const char *file_name, bool sync)
 start_process (void *data)
 {
   struct spawn_node *snode = (struct spawn_node*)data;
+  struct process_args *args = snode->args;
   struct intr_frame if_;
-  const char *procname = thread_current()->name;
+  const char *procname = args->strings + args_ofs(args)[-1];
 
   bool success;
   /* Initialize interrupt frame and load executable. */
@@ -169,18 +333,17 @@ start_process (void *data)
   if_.cs = SEL_UCSEG;
   if_.eflags = FLAG_IF | FLAG_MBS;
 
-  /* Create page for command line argument and argument address. */
   success = load (procname, &if_.eip, &if_.esp);
   if(success)
-      if_.esp = push_args(snode->args, if_.esp);
-
-  if(!if_.esp)
-      success = false;
+      if_.esp = push_args(args, if_.esp);
 
   /* If load failed, quit. */
   if(success)
       success = process_init(procname, snode->ptid);
-  palloc_free_page (snode->arg_page);
+  if(success && snode->parent)
+      success = fd_copy(&thread_current()->proc->fd_node,
+                        &snode->parent->fd_node, process_dup_file);
+  process_args_destroy (args);
 
   if(spawn_node_is_sync_set(snode))
   {
@@ -204,6 +367,107 @@ start_process (void *data)
   NOT_REACHED ();
 }
 
+#ifdef VM
+/* Creates a child process that is a copy of the running one and
+   resumes from user state F, except that fork returns 0 in the
+   child.  The child shares every frame of our address space
+   copy-on-write, so the cost is proportional to the size of our
+   page tables rather than to our resident memory.  Returns the
+   child's thread id, or TID_ERROR if it could not be created. */
+tid_t
+process_fork(const struct intr_frame *f)
+{
+    struct fork_node fnode;
+    tid_t tid;
+
+    fnode.if_ = *f;
+    fnode.parent = thread_current();
+    sema_init(&fnode.sema, 0);
+
+    tid = thread_create(thread_current()->name, thread_get_priority(),
+                        fork_process, &fnode);
+    if(tid == TID_ERROR)
+        return TID_ERROR;
+
+    process_insert_child(tid);
+    sema_down(&fnode.sema);
+    if(!fnode.success)
+    {
+        struct process_child_node *childs = &thread_current()->proc->childs;
+        lock_acquire(&childs->lock);
+        process_remove_child(childs, process_search_child(childs, tid));
+        lock_release(&childs->lock);
+        tid = TID_ERROR;
+    }
+    return tid;
+}
+
+/* A thread function that turns a new thread into a copy of the
+   process that is blocked in process_fork(), then starts it
+   running. */
+static void
+fork_process(void *data)
+{
+    struct fork_node *fnode = (struct fork_node*)data;
+    struct thread *parent = fnode->parent;
+    struct thread *cur = thread_current();
+    struct intr_frame if_ = fnode->if_;
+    bool success = false;
+
+    cur->pagedir = pagedir_clone(parent->pagedir);
+    if(cur->pagedir
+    && page_table_copy(parent->pages)
+    && process_init(NULL, parent->tid))
+    {
+        process_activate();
+        success = process_copy(parent->proc);
+    }
+
+    /* FNODE lives on the parent's stack, so it must not be
+       touched once the parent is woken up. */
+    fnode->success = success;
+    sema_up(&fnode->sema);
+
+    if(!success)
+        thread_exit();
+
+    if_.eax = 0;
+    asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+
+    NOT_REACHED ();
+}
+
+/* Gives the running process its own handles on the executable
+   and the open files of process PARENT.  Each file is reopened
+   at the same position; the position is not shared afterwards.
+   The system call ring, if any, is at the same address in our
+   copy of PARENT's memory. */
+static bool
+process_copy(struct process *parent)
+{
+    struct process *proc = thread_current()->proc;
+
+    if(parent->exe)
+    {
+        proc->exe = file_reopen(parent->exe);
+        if(!proc->exe)
+            return false;
+        file_deny_write(proc->exe);
+    }
+    proc->ring = parent->ring;
+    return fd_copy(&proc->fd_node, &parent->fd_node, process_dup_file);
+}
+#endif
+
+static struct file*
+process_dup_file(struct file *file)
+{
+    struct file *copy = file_reopen(file);
+    if(copy)
+        file_seek(copy, file_tell(file));
+    return copy;
+}
+
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If TID is invalid or if it was not a
@@ -229,17 +493,60 @@ process_wait (tid_t child_tid)
     child = process_search_child(childs, child_tid);
     if(child)
     {
-        if(!child->status)
+        while(!child->exited)
         {
-            cond_wait(&childs->cond, &childs->lock);
+            lock_release(&childs->lock);
+            sema_down(&childs->exit_sema);
+            lock_acquire(&childs->lock);
         }
-        status = *child->status;
-        process_remove_child(child);
+        status = child->status;
+        process_remove_child(childs, child);
     }
     lock_release(&childs->lock);
     return status;
 }
 
+/* Reaps whichever child of the running process exited first
+   among those not yet waited for, storing its exit status in
+   *STATUS and returning its thread id.  If none has exited,
+   waits for one for up to TICKS timer ticks, or for as long as
+   it takes if TICKS is negative, and returns 0 if none did.
+   Returns TID_ERROR at once if there are no children to wait
+   for. */
+tid_t
+process_wait_any(int *status, int64_t ticks)
+{
+    struct process_child_node *childs = &thread_current()->proc->childs;
+    int64_t start = timer_ticks();
+
+    for(;;)
+    {
+        tid_t tid = 0;
+
+        lock_acquire(&childs->lock);
+        if(!list_empty(&childs->exited))
+        {
+            struct child_node *child = list_entry(list_front(&childs->exited),
+                                                  struct child_node, elem);
+            tid = child->tid;
+            *status = child->status;
+            process_remove_child(childs, child);
+        }
+        else if(ihash_empty(&childs->hash))
+            tid = TID_ERROR;
+        lock_release(&childs->lock);
+
+        if(tid != 0)
+            return tid;
+        if(ticks < 0)
+            sema_down(&childs->exit_sema);
+        else if(timer_elapsed(start) >= ticks
+             || !sema_down_timeout(&childs->exit_sema,
+                                   ticks - timer_elapsed(start)))
+            return 0;
+    }
+}
+
 /* Free the current process's resources. */
 void
 process_exit (void)
@@ -263,6 +570,9 @@ process_exit (void)
       pagedir_activate (NULL);
       pagedir_destroy (pd);
     }
+#ifdef VM
+  page_table_destroy ();
+#endif
 }
 
 /* Sets up the CPU for running user code in the current
@@ -346,6 +656,7 @@ struct Elf32_Phdr
 
 //static
 bool setup_stack (void **esp);
+static struct image *read_image (struct file *);
 static bool validate_segment (const struct Elf32_Phdr *, struct file *);
 static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
                           uint32_t read_bytes, uint32_t zero_bytes,
@@ -360,15 +671,18 @@ bool
 load (const char *file_name, void (**eip) (void), void **esp)
 {
   struct thread *t = thread_current ();
-  struct Elf32_Ehdr ehdr;
+  struct image *image = NULL;
   struct file *file = NULL;
-  off_t file_ofs;
   bool success = false;
-  int i;
+  size_t i;
   /* Allocate and activate page directory. */
   t->pagedir = pagedir_create ();
   if (t->pagedir == NULL) 
     goto done;
+#ifdef VM
+  if (!page_table_init ())
+    goto done;
+#endif
   process_activate ();
 
   /* Open executable file. */
@@ -379,7 +693,58 @@ load (const char *file_name, void (**eip) (void), void **esp)
       goto done; 
     }
 
+  /* Read the headers, unless we have already. */
+  image = image_get (file_get_inode (file));
+  if (image == NULL)
+    {
+      image = read_image (file);
+      if (image == NULL)
+        {
+          printf ("load: %s: error loading executable\n", file_name);
+          goto done; 
+        }
+      image_put (file_get_inode (file), image);
+    }
+
+  /* Map segments. */
+  for (i = 0; i < image->seg_cnt; i++)
+    {
+      const struct image_segment *seg = &image->segs[i];
+      if (!load_segment (file, seg->ofs, seg->upage, seg->read_bytes,
+                         seg->zero_bytes, seg->writable))
+        goto done;
+    }
+
+  /* Set up stack. */
+  if (!setup_stack (esp))
+    goto done;
+
+  /* Start address. */
+  *eip = image->entry;
+
+  success = true;
+
+ done:
+  /* We arrive here whether the load is successful or not. */
+  free (image);
+  file_close (file);
+  return success;
+}
+
+/* Reads and checks the ELF headers of executable FILE and
+   returns its image, which the caller must free().  Returns a
+   null pointer if FILE is not an executable we can load or if
+   memory is not available. */
+static struct image *
+read_image (struct file *file)
+{
+  struct Elf32_Ehdr ehdr;
+  struct image *image;
+  off_t file_ofs;
+  int i;
+
   /* Read and verify executable header. */
+  file_seek (file, 0);
   if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
       || memcmp (ehdr.e_ident, "\177ELF\1\1\1", 7)
       || ehdr.e_type != 2
@@ -387,23 +752,25 @@ load (const char *file_name, void (**eip) (void), void **esp)
       || ehdr.e_version != 1
       || ehdr.e_phentsize != sizeof (struct Elf32_Phdr)
       || ehdr.e_phnum > 1024) 
-    {
-      printf ("load: %s: error loading executable\n", file_name);
-      goto done; 
-    }
+    return NULL;
 
-  /* Read program headers. */
+  /* Read program headers, with room for each to be a loadable
+     segment. */
+  image = malloc (IMAGE_SIZE (ehdr.e_phnum));
+  if (image == NULL)
+    return NULL;
+  image->seg_cnt = 0;
   file_ofs = ehdr.e_phoff;
   for (i = 0; i < ehdr.e_phnum; i++) 
     {
       struct Elf32_Phdr phdr;
 
       if (file_ofs < 0 || file_ofs > file_length (file))
-        goto done;
+        goto error;
       file_seek (file, file_ofs);
 
       if (file_read (file, &phdr, sizeof phdr) != sizeof phdr)
-        goto done;
+        goto error;
       file_ofs += sizeof phdr;
       switch (phdr.p_type) 
         {
@@ -417,53 +784,46 @@ load (const char *file_name, void (**eip) (void), void **esp)
         case PT_DYNAMIC:
         case PT_INTERP:
         case PT_SHLIB:
-          goto done;
+          goto error;
         case PT_LOAD:
           if (validate_segment (&phdr, file)) 
             {
-              bool writable = (phdr.p_flags & PF_W) != 0;
-              uint32_t file_page = phdr.p_offset & ~PGMASK;
-              uint32_t mem_page = phdr.p_vaddr & ~PGMASK;
+              struct image_segment *seg = &image->segs[image->seg_cnt++];
               uint32_t page_offset = phdr.p_vaddr & PGMASK;
-              uint32_t read_bytes, zero_bytes;
+              seg->writable = (phdr.p_flags & PF_W) != 0;
+              seg->ofs = phdr.p_offset & ~PGMASK;
+              seg->upage = (uint8_t *) (phdr.p_vaddr & ~PGMASK);
               if (phdr.p_filesz > 0)
                 {
                   /* Normal segment.
                      Read initial part from disk and zero the rest. */
-                  read_bytes = page_offset + phdr.p_filesz;
-                  zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz, PGSIZE)
-                                - read_bytes);
+                  seg->read_bytes = page_offset + phdr.p_filesz;
+                  seg->zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz,
+                                               PGSIZE)
+                                     - seg->read_bytes);
                 }
               else 
                 {
                   /* Entirely zero.
                      Don't read anything from disk. */
-                  read_bytes = 0;
-                  zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
+                  seg->read_bytes = 0;
+                  seg->zero_bytes = ROUND_UP (page_offset + phdr.p_memsz,
+                                              PGSIZE);
                 }
-              if (!load_segment (file, file_page, (void *) mem_page,
-                                 read_bytes, zero_bytes, writable))
-                goto done;
             }
           else
-            goto done;
+            goto error;
           break;
         }
     }
 
-  /* Set up stack. */
-  if (!setup_stack (esp))
-    goto done;
-
   /* Start address. */
-  *eip = (void (*) (void)) ehdr.e_entry;
+  image->entry = (void (*) (void)) ehdr.e_entry;
+  return image;
 
-  success = true;
-
- done:
-  /* We arrive here whether the load is successful or not. */
-  file_close (file);
-  return success;
+ error:
+  free (image);
+  return NULL;
 }
 
 /* load() helpers. */
@@ -546,6 +906,17 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
       size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
       size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
+#ifdef VM
+      /* Nothing is read until the page is first touched (see
+         vm/page.c). */
+      if (pagedir_get_page (thread_current ()->pagedir, upage) != NULL)
+        return false;
+      if (page_read_bytes == 0
+          ? !page_add_zero (upage, writable)
+          : !page_add_file (upage, file_get_inode (file), ofs,
+                            page_read_bytes, writable))
+        return false;
+#else
       /* Get a page of memory. */
       uint8_t *kpage = palloc_get_page (PAL_USER);
       if (kpage == NULL)
@@ -565,11 +936,13 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
           palloc_free_page (kpage);
           return false; 
         }
+#endif
 
       /* Advance. */
       read_bytes -= page_read_bytes;
       zero_bytes -= page_zero_bytes;
       upage += PGSIZE;
+      ofs += PGSIZE;
     }
   return true;
 }
@@ -583,7 +956,11 @@ setup_stack (void **esp)
   uint8_t *kpage;
   bool success = false;
 
+#ifdef VM
+  kpage = frame_alloc (PAL_ZERO);
+#else
   kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+#endif
   if (kpage != NULL) 
     {
       success = install_page (((uint8_t *) PHYS_BASE) - PGSIZE, kpage, true);
@@ -592,7 +969,11 @@ setup_stack (void **esp)
           *esp = PHYS_BASE;
       }
       else
+#ifdef VM
+        frame_release (kpage);
+#else
         palloc_free_page (kpage);
+#endif
     }
   return success;
 }
@@ -618,59 +999,54 @@ install_page (void *upage, void *kpage, bool writable)
 }
 
 
-/* This following function prepares the stack for user. */
-static char*
-push_args(char *src, char *dest)
+/* Copies ARGS onto the stack that ends at ESP, followed by the
+   argv and argc of a call to main() and a null return address.
+   Returns the new stack pointer.  The strings go in with one
+   copy; process_args_next() left room for the rest. */
+static void*
+push_args(struct process_args *args, void *esp)
 {
-    char *cur = NULL;
-    int32_t argc = 0;
-    int32_t idx = 0;
+    uint32_t *ofs = args_ofs(args);
+    char *strings = (char*)esp - args->len;
+    void *cur;
     uintptr_t argv;
-    uintptr_t *addr;
-
-    addr = palloc_get_page(0);
-    if(!addr)
-        return NULL;
-
-    addr[idx] = 0;
+    int idx;
 
-    cur = thread_current()->name;
-    dest -= strlen(cur) + 1;
-    strlcpy(dest, cur, strlen(cur) + 1);
-    addr[argc++] = (uintptr_t)dest;
-
-    /* Copy the bytes to page and also keep track of the start of each argument. */
-    while((cur = strtok_r(NULL, " ", &src)))
-    {
-        dest -= strlen(cur) + 1;
-        strlcpy(dest, cur, strlen(cur) + 1);
-        addr[argc++] = (uintptr_t)dest;
-    }
+    memcpy(strings, args->strings, args->len);
 
     /* Align to the word boundary. */
-    cur = align_word(dest);
-    cur = get_prev_addr(cur);
+    cur = get_prev_addr(align_word(strings));
     *(uintptr_t*)cur = 0;
 
     /* Start pushing the address of arguments. */
-    for(idx = argc - 1; idx >= 0; --idx)
+    for(idx = args->argc - 1; idx >= 0; --idx)
     {
         cur = get_prev_addr(cur);
-        *(uintptr_t*)cur = (uintptr_t)addr[idx];
+        *(uintptr_t*)cur = (uintptr_t)(strings + ofs[-1 - idx]);
     }
 
     argv = (uintptr_t)cur;
-    cur = (char*)get_prev_addr(cur);
-    *(uintptr_t*)cur = (uintptr_t)argv;
-    cur = (char*)get_prev_addr(cur);
-    *(uintptr_t*)cur = (uintptr_t)argc;
-    cur = (char*)get_prev_addr(cur);
+    cur = get_prev_addr(cur);
+    *(uintptr_t*)cur = argv;
+    cur = get_prev_addr(cur);
+    *(uintptr_t*)cur = (uintptr_t)args->argc;
+    cur = get_prev_addr(cur);
     *(uintptr_t*)cur = 0;
 
-    palloc_free_page(addr);
     return cur;
 }
 
+/* Sets up the caches that processes are allocated from. */
+void
+process_caches_init(void)
+{
+    slab_cache_init(&process_cache, "process", sizeof(struct process), NULL);
+    slab_cache_init(&spawn_cache, "spawn_node", sizeof(struct spawn_node),
+                    spawn_node_ctor);
+    slab_cache_init(&child_cache, "child_node", sizeof(struct child_node),
+                    NULL);
+}
+
 /* Initialized the process,
  * In case of failure, cleanup activity will be done by process_destroy
  * which is been called from thread_exit()
@@ -681,7 +1057,7 @@ process_init(const char *exe_name, tid_t ptid)
     struct process *proc;
     struct process_child_node *childs;
 
-    proc = malloc(sizeof(struct process));
+    proc = slab_alloc(&process_cache);
     if(!proc)
         return false;
 
@@ -692,12 +1068,17 @@ process_init(const char *exe_name, tid_t ptid)
             return false;
         file_deny_write(proc->exe);
     }
+    else
+        proc->exe = NULL;
+    proc->ring = NULL;
 
     childs = &proc->childs;
     childs->ptid = ptid;
     lock_init(&childs->lock);
-    cond_init(&childs->cond);
-    list_init(&childs->list);
+    sema_init(&childs->exit_sema, 0);
+    list_init(&childs->exited);
+    if(!ihash_init(&childs->hash, NULL))
+        return false;
 
     if(!fd_init(&proc->fd_node))
         return false;
@@ -719,7 +1100,10 @@ void process_destroy(void)
             file_close(proc->exe);
         }
         fd_destroy(&proc->fd_node, file_close);
-        free(proc);
+        lock_acquire(&proc->childs.lock);
+        ihash_destroy(&proc->childs.hash, child_free);
+        lock_release(&proc->childs.lock);
+        slab_free(&process_cache, proc);
     }
 }
 
@@ -731,46 +1115,47 @@ process_insert_child(tid_t tid)
 
     childs = &thread_current()->proc->childs;
 
-    child = (struct child_node*)malloc(sizeof(struct child_node));
+    child = slab_alloc(&child_cache);
     if(!child)
     {
         ASSERT(0);
     }
 
     child->tid = tid;
-    child->status = NULL;
+    child->exited = false;
     lock_acquire(&childs->lock);
-    list_push_back(&childs->list, &child->elem);
+    if(!ihash_insert(&childs->hash, tid, child))
+    {
+        ASSERT(0);
+    }
     lock_release(&childs->lock);
 }
 
 static struct child_node*
 process_search_child(struct process_child_node *childs, tid_t tid)
 {
-    struct list_elem *elem;
-    for(elem = list_begin(&childs->list);
-        elem != list_end(&childs->list);
-        elem = list_next(elem))
-    {
-        struct child_node *child = list_entry(elem, struct child_node, elem);
-        if(child->tid == tid)
-            return child;
-    }
-    return NULL;
+    return ihash_find(&childs->hash, tid);
 }
 
 static void
-process_remove_child(struct child_node *child)
+process_remove_child(struct process_child_node *childs,
+                     struct child_node *child)
 {
     if(child)
     {
-        list_remove(&child->elem);
-        if(child->status)
-            free(child->status);
-        free(child);
+        ihash_delete(&childs->hash, child->tid);
+        if(child->exited)
+            list_remove(&child->elem);
+        slab_free(&child_cache, child);
     }
 }
 
+static void
+child_free(struct ihash_slot *s, void *aux UNUSED)
+{
+    slab_free(&child_cache, s->value);
+}
+
 /* This function notifies parent process about the exit status.
    If parent process has exited before the call is made then this function does nothing.
  */
@@ -792,9 +1177,12 @@ process_notify(int status)
         child = process_search_child(childs, thread_current()->tid);
         if(child)
         {
-            child->status = malloc(sizeof(int));
-            *child->status = status;
-            cond_signal(&childs->cond, &childs->lock);
+            child->exited = true;
+            child->status = status;
+            list_push_back(&childs->exited, &child->elem);
+            /* Signal while holding the lock: once it is released
+               the parent may reap us, exit and free CHILDS. */
+            sema_up(&childs->exit_sema);
         }
         lock_release(&childs->lock);
     }
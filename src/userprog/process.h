@@ -3,12 +3,26 @@
 
 #include "threads/thread.h"
 
+void process_caches_init(void);
 bool process_init(const char *exe_name, tid_t ptid);
 void process_destroy(void);
 void process_notify(int status);
+struct process_args;
+
+struct process_args* process_args_create(void);
+void process_args_destroy(struct process_args *args);
+char* process_args_next(struct process_args *args, size_t *room);
+void process_args_add(struct process_args *args, size_t len);
+bool process_args_split(struct process_args *args);
+
 tid_t process_execute (const char *file_name);
-tid_t process_execute_sync(const char *file_name);
+tid_t process_spawn(struct process_args *args, bool inherit_fds);
+#ifdef VM
+struct intr_frame;
+tid_t process_fork(const struct intr_frame *f);
+#endif
 int process_wait (tid_t);
+tid_t process_wait_any (int *status, int64_t ticks);
 void process_exit (void);
 void process_activate (void);
 
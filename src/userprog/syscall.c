@@ -2,13 +2,21 @@
 #include <stdio.h>
 #include <string.h>
 #include <syscall-nr.h>
+#include <ring.h>
+#include <spawn.h>
+#include <uio.h>
 #include "threads/interrupt.h"
+#include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "devices/shutdown.h"
 #include "devices/input.h"
+#include "devices/timer.h"
+#include "userprog/exception.h"
+#include "userprog/image.h"
 #include "userprog/process.h"
-#include "userprog/pagedir.h"
+#include "userprog/tss.h"
+#include "filesys/directory.h"
 #include "filesys/filesys.h"
 #include "filesys/file.h"
 #include "filesys/fd.h"
@@ -16,7 +24,8 @@
 
 struct argv
 {
-    void *arg[3];
+    void *arg[4];
+    struct intr_frame *frame;   /* Caller's user state. */
 };
 
 typedef void (syscall_fn)(struct argv *args, uint32_t *eax);
@@ -27,9 +36,16 @@ struct syscall
     int argc;
 };
 
-static bool is_valid_user_vaddr(const void *addr);
+static inline int get_user(const uint8_t *uaddr);
+static inline bool put_user(uint8_t *udst, uint8_t byte);
+static bool is_user_range(const void *uaddr, size_t size);
+static bool copy_from_user(void *dst, const void *usrc, size_t size);
+static bool copy_to_user(void *udst, const void *src, size_t size);
+static int strncpy_from_user(char *dst, const char *usrc, size_t size);
+static bool copy_user_string(char *dst, const char *usrc, size_t size);
+static bool is_valid_user_buffer(const void *buff, unsigned size);
+static bool is_writable_user_buffer(void *buff, unsigned size);
 static void force_exit(int status);
-static void syscall_handler (struct intr_frame *);
 static int syscall_get(intptr_t *num);
 static void syscall_get_args(intptr_t *addr, int argc, struct argv *args);
 static void syscall_halt(struct argv *args, uint32_t *eax);
@@ -45,6 +61,28 @@ static void syscall_write(struct argv *args, uint32_t *eax);
 static void syscall_seek(struct argv *args, uint32_t *eax UNUSED);
 static void syscall_tell(struct argv *args, uint32_t *eax);
 static void syscall_close(struct argv *args, uint32_t *eax UNUSED);
+static void syscall_fork(struct argv *args, uint32_t *eax);
+static void syscall_sysenter(struct argv *args, uint32_t *eax);
+static void syscall_readv(struct argv *args, uint32_t *eax);
+static void syscall_writev(struct argv *args, uint32_t *eax);
+static void syscall_pread(struct argv *args, uint32_t *eax);
+static void syscall_pwrite(struct argv *args, uint32_t *eax);
+static void syscall_ring_setup(struct argv *args, uint32_t *eax);
+static void syscall_ring_enter(struct argv *args, uint32_t *eax);
+static void syscall_sendfile(struct argv *args, uint32_t *eax);
+static void syscall_spawn(struct argv *args, uint32_t *eax);
+static void syscall_waitany(struct argv *args, uint32_t *eax);
+static struct file* get_file(int fd);
+static void copy_iovec_from_user(struct iovec *iov, const struct iovec *uiov,
+                                 int iovcnt, bool write);
+static int file_transfer_at(struct file *file, const struct iovec *iov,
+                            int iovcnt, off_t pos, bool write);
+
+/* Fast system call entry point, in sysenter.S. */
+void sysenter_entry(void);
+
+/* True if user programs may use SYSENTER. */
+static bool sysenter_enabled;
 
 
 static
@@ -69,13 +107,202 @@ struct syscall syscall_tbl[] =
     {NULL,                      0},
     {NULL,                      0},
     {NULL,                      0},
-    {NULL,                      0}
+    {NULL,                      0},
+    {syscall_fork,              0},
+    {syscall_sysenter,          0},
+    {syscall_readv,             3},
+    {syscall_writev,            3},
+    {syscall_pread,             4},
+    {syscall_pwrite,            4},
+    {syscall_ring_setup,        1},
+    {syscall_ring_enter,        0},
+    {syscall_sendfile,          3},
+    {syscall_spawn,             2},
+    {syscall_waitany,           2}
 };
 
+/* User memory access.
+
+   The kernel reads and writes user memory by simply
+   dereferencing user pointers, without looking them up in the
+   page directory first.  An address that is not mapped makes
+   the access fault, and page_fault() recovers: each instruction
+   below that touches user memory has an entry in the exception
+   table, and the fault handler resumes at the entry's fixup
+   label with EAX set to -1.  Only the range check against
+   PHYS_BASE has to be made up front, because kernel addresses
+   do not fault. */
+
+/* Reads a byte at user virtual address UADDR, which must be
+   below PHYS_BASE.  Returns the byte value if successful, -1 if
+   a fault occurred. */
+static inline int
+get_user(const uint8_t *uaddr)
+{
+    int result;
+    asm volatile ("1: movzbl %1, %0; 2:"
+                  EXCEPTION_ENTRY("1b", "2b")
+                  : "=a" (result) : "m" (*uaddr));
+    return result;
+}
+
+/* Writes BYTE to user address UDST, which must be below
+   PHYS_BASE.  Returns true if successful, false if a fault
+   occurred. */
+static inline bool
+put_user(uint8_t *udst, uint8_t byte)
+{
+    int error_code;
+    asm volatile ("xorl %0, %0; 1: movb %b2, %1; 2:"
+                  EXCEPTION_ENTRY("1b", "2b")
+                  : "=&a" (error_code), "=m" (*udst) : "q" (byte));
+    return error_code != -1;
+}
+
+/* Returns true if UADDR..UADDR+SIZE lies below PHYS_BASE. */
 static bool
-is_valid_user_vaddr(const void *addr)
+is_user_range(const void *uaddr, size_t size)
 {
-    return is_user_vaddr(addr) && pagedir_get_page(thread_current()->pagedir, addr);
+    uintptr_t start = (uintptr_t)uaddr;
+    return start + size >= start && start + size <= (uintptr_t)PHYS_BASE;
+}
+
+/* Copies SIZE bytes from user address USRC to DST.  Returns
+   true if successful, false if USRC is not user memory. */
+static bool
+copy_from_user(void *dst, const void *usrc, size_t size)
+{
+    int error_code;
+
+    if(!is_user_range(usrc, size))
+        return false;
+    asm volatile ("xorl %0, %0; 1: rep movsb; 2:"
+                  EXCEPTION_ENTRY("1b", "2b")
+                  : "=&a" (error_code), "+D" (dst), "+S" (usrc), "+c" (size)
+                  : : "memory");
+    return error_code == 0;
+}
+
+/* Copies SIZE bytes from SRC to user address UDST.  Returns true
+   if successful, false if UDST is not writable user memory. */
+static bool
+copy_to_user(void *udst, const void *src, size_t size)
+{
+    int error_code;
+
+    if(!is_user_range(udst, size))
+        return false;
+    asm volatile ("xorl %0, %0; 1: rep movsb; 2:"
+                  EXCEPTION_ENTRY("1b", "2b")
+                  : "=&a" (error_code), "+D" (udst), "+S" (src), "+c" (size)
+                  : : "memory");
+    return error_code == 0;
+}
+
+/* Returns the length of the string at user address USRC, or
+   SIZE if there is no null byte among its first SIZE bytes, or
+   -1 if a fault occurred.  USRC..USRC+SIZE must lie below
+   PHYS_BASE and SIZE must not be 0. */
+static int
+strnlen_user(const char *usrc, size_t size)
+{
+    const char *end = usrc;
+    size_t left = size;
+    int error_code;
+    uint8_t found = 0;
+
+    asm volatile ("xorl %0, %0; 1: repnz scasb; setz %1; 2:"
+                  EXCEPTION_ENTRY("1b", "2b")
+                  : "=&a" (error_code), "+q" (found), "+D" (end), "+c" (left)
+                  : : "memory");
+    if(error_code == -1)
+        return -1;
+    return found ? end - usrc - 1 : (int)size;
+}
+
+/* Copies the string at user address USRC into DST, which holds
+   SIZE bytes.  Returns the length of the string, SIZE if it did
+   not fit (DST is then not null-terminated), or -1 if it is not
+   in user memory.  The string is measured and copied a page at
+   a time, with one string instruction each. */
+static int
+strncpy_from_user(char *dst, const char *usrc, size_t size)
+{
+    size_t len = 0;
+
+    while(len < size)
+    {
+        const char *uaddr = usrc + len;
+        size_t chunk = (const char *)pg_round_down(uaddr) + PGSIZE - uaddr;
+        int n;
+
+        if(!is_user_vaddr(uaddr))
+            return -1;
+        if(chunk > size - len)
+            chunk = size - len;
+        n = strnlen_user(uaddr, chunk);
+        if(n < 0)
+            return -1;
+        if((size_t)n < chunk)
+            return copy_from_user(dst + len, uaddr, n + 1) ? (int)(len + n) : -1;
+        if(!copy_from_user(dst + len, uaddr, chunk))
+            return -1;
+        len += chunk;
+    }
+    return size;
+}
+
+/* Copies the string at user address USRC into DST, which holds
+   SIZE bytes, killing the process if it is not in user memory.
+   Returns false if the string does not fit. */
+static bool
+copy_user_string(char *dst, const char *usrc, size_t size)
+{
+    int len = strncpy_from_user(dst, usrc, size);
+    if(len < 0)
+        force_exit(-1);
+    return (size_t)len < size;
+}
+
+/* Returns true if every page of BUFF..BUFF+SIZE can be read by
+   the current process.  The file system reads such buffers in
+   place, so each page is touched once here: under VM this also
+   brings in pages that are not present yet, which must not
+   happen from inside the block layer. */
+static bool
+is_valid_user_buffer(const void *buff, unsigned size)
+{
+    const uint8_t *uaddr = buff;
+    const uint8_t *end = uaddr + size;
+
+    if(!is_user_range(buff, size))
+        return false;
+    for(; uaddr < end; uaddr = (const uint8_t *)pg_round_down(uaddr) + PGSIZE)
+        if(get_user(uaddr) == -1)
+            return false;
+    return true;
+}
+
+/* Returns true if every page of BUFF..BUFF+SIZE can be written
+   by the current process, touching each page as above.  The
+   kernel honors read-only user mappings (CR0.WP is set), so a
+   read into a page such as program text fails here rather than
+   in the middle of the file system. */
+static bool
+is_writable_user_buffer(void *buff, unsigned size)
+{
+    uint8_t *uaddr = buff;
+    uint8_t *end = uaddr + size;
+
+    if(!is_user_range(buff, size))
+        return false;
+    for(; uaddr < end; uaddr = (uint8_t *)pg_round_down(uaddr) + PGSIZE)
+    {
+        int c = get_user(uaddr);
+        if(c == -1 || !put_user(uaddr, c))
+            return false;
+    }
+    return true;
 }
 
 static void
@@ -89,37 +316,40 @@ void
 syscall_init (void) 
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
+  sysenter_enabled = tss_enable_sysenter (sysenter_entry);
 }
 
-static void
+/* Handles a system call made with INT $0x30, or with SYSENTER
+   by way of sysenter_entry. */
+void
 syscall_handler (struct intr_frame *f)
 {
   void *addr = f->esp;
   int sys_num = syscall_get(addr);
   struct syscall *sysc = &syscall_tbl[sys_num];
   struct argv args;
+  if(!sysc->fn)
+      force_exit(-1);
   syscall_get_args(addr, sysc->argc, &args);
+  args.frame = f;
   sysc->fn(&args, &f->eax);
 }
 
 static int
 syscall_get(intptr_t *num)
 {
-    if(!is_valid_user_vaddr(num) || *num < SYS_HALT || *num > SYS_INUMBER)
+    intptr_t sys_num;
+    if(!copy_from_user(&sys_num, num, sizeof sys_num) || sys_num < SYS_HALT
+    || sys_num >= (intptr_t)(sizeof syscall_tbl / sizeof *syscall_tbl))
         force_exit(-1);
-    return *num;
+    return sys_num;
 }
 
 static void
 syscall_get_args(intptr_t *addr, int argc, struct argv *args)
 {
-    int i;
-    for(i = 1; i <= argc; ++i)
-    {
-        if(!is_valid_user_vaddr(addr + i))
-            force_exit(-1);
-        args->arg[i - 1] = (void*)*(addr + i);
-    }
+    if(!copy_from_user(args->arg, addr + 1, argc * sizeof *args->arg))
+        force_exit(-1);
 }
 
 static void
@@ -138,11 +368,33 @@ syscall_exit(struct argv *args, uint32_t *eax)
 static void
 syscall_exec(struct argv *args, uint32_t *eax)
 {
-    const char *filename = (const char*)args->arg[0];
-    if(!is_valid_user_vaddr(filename))
-        force_exit(-1);
-    *eax = process_execute_sync(filename);
+    const char *cmd_line = (const char*)args->arg[0];
+    struct process_args *pargs;
+    size_t room;
+    char *dst;
+    int len;
+
+    pargs = process_args_create();
+    if(!pargs)
+    {
+        *eax = TID_ERROR;
+        return;
+    }
 
+    dst = process_args_next(pargs, &room);
+    len = strncpy_from_user(dst, cmd_line, room);
+    if(len < 0)
+    {
+        process_args_destroy(pargs);
+        force_exit(-1);
+    }
+    if((size_t)len < room && process_args_split(pargs))
+        *eax = process_spawn(pargs, false);
+    else
+    {
+        process_args_destroy(pargs);
+        *eax = TID_ERROR;
+    }
 }
 
 static void
@@ -152,49 +404,38 @@ syscall_wait(struct argv *args, uint32_t *eax)
     *eax = process_wait(pid);
 }
 
+/* A name that does not fit in NAME may be valid user memory,
+   but it cannot name a file. */
 static void
 syscall_create(struct argv *args, uint32_t *eax)
 {
-    const char *name;
+    char name[NAME_MAX + 1];
     off_t size;
 
-    name = (const char*)args->arg[0];
-    if(!name
-    || !is_valid_user_vaddr(name)
-    || !is_valid_user_vaddr(name + strlen(name)))
-        force_exit(-1);
-
     size = (off_t)args->arg[1];
-    *eax = filesys_create (name, size);
+    *eax = copy_user_string(name, (const char*)args->arg[0], sizeof name)
+           && filesys_create(name, size);
 }
 
 static void
 syscall_remove(struct argv *args, uint32_t *eax)
 {
-    const char *name;
+    char name[NAME_MAX + 1];
 
-    name = (const char*)args->arg[0];
-    if(!name
-    || !is_valid_user_vaddr(name)
-    || !is_valid_user_vaddr(name + strlen(name)))
-        force_exit(-1);
-
-    *eax = filesys_remove(name);
+    *eax = copy_user_string(name, (const char*)args->arg[0], sizeof name)
+           && filesys_remove(name);
+    if(*eax)
+        image_drop_removed();
 }
 
 static void
 syscall_open(struct argv *args, uint32_t *eax)
 {
-    const char *name;
-    struct file *file;
+    char name[NAME_MAX + 1];
+    struct file *file = NULL;
 
-    name = (const char*)args->arg[0];
-    if(!name
-    ||!is_valid_user_vaddr(name)
-    || !is_valid_user_vaddr(name + strlen(name)))
-        force_exit(-1);
-
-    file = filesys_open(name);
+    if(copy_user_string(name, (const char*)args->arg[0], sizeof name))
+        file = filesys_open(name);
     if(!file)
         *eax = FD_INVALID;
     else
@@ -233,8 +474,7 @@ syscall_read(struct argv *args, uint32_t *eax)
     size = (unsigned)args->arg[2];
 
     if(!buff
-    || !is_valid_user_vaddr(buff)
-    || !is_valid_user_vaddr(buff + size))
+    || !is_writable_user_buffer(buff, size))
         force_exit(-1);
 
     *eax = 0;
@@ -243,7 +483,9 @@ syscall_read(struct argv *args, uint32_t *eax)
     {
         if(size >= sizeof(uint8_t))
         {
-            buff[0] = input_getc();
+            uint8_t c = input_getc();
+            if(!copy_to_user(buff, &c, sizeof c))
+                force_exit(-1);
             *eax = sizeof(uint8_t);
         }
     }
@@ -267,8 +509,7 @@ syscall_write(struct argv *args, uint32_t *eax)
     size = (unsigned)args->arg[2];
 
     if(!buff
-    || !is_valid_user_vaddr(buff)
-    || !is_valid_user_vaddr(buff + size))
+    || !is_valid_user_buffer(buff, size))
         force_exit(-1);
 
     *eax = 0;
@@ -326,3 +567,401 @@ syscall_close(struct argv *args, uint32_t *eax UNUSED)
             file_close(file);
     }
 }
+
+static void
+syscall_fork(struct argv *args, uint32_t *eax)
+{
+#ifdef VM
+    *eax = process_fork(args->frame);
+#else
+    /* Copy-on-write needs the frame table of the VM kernel. */
+    (void)args;
+    *eax = TID_ERROR;
+#endif
+}
+
+/* Tells the user library whether it may enter the kernel with
+   SYSENTER.  Also serves as a null system call. */
+static void
+syscall_sysenter(struct argv *args UNUSED, uint32_t *eax)
+{
+    *eax = sysenter_enabled;
+}
+
+/* Returns the open file with descriptor FD in the current
+   process, or a null pointer if there is none. */
+static struct file*
+get_file(int fd)
+{
+    if(fd < FD_MIN || fd > FD_MAX)
+        return NULL;
+    return fd_search(&thread_current()->proc->fd_node, fd);
+}
+
+/* Copies the IOVCNT buffers at user address UIOV into IOV and
+   checks that each is user memory, writable if WRITE is true.
+   Kills the process otherwise. */
+static void
+copy_iovec_from_user(struct iovec *iov, const struct iovec *uiov,
+                     int iovcnt, bool write)
+{
+    int i;
+
+    if(!copy_from_user(iov, uiov, iovcnt * sizeof *iov))
+        force_exit(-1);
+    for(i = 0; i < iovcnt; i++)
+    {
+        if(write
+           ? !is_writable_user_buffer(iov[i].iov_base, iov[i].iov_len)
+           : !is_valid_user_buffer(iov[i].iov_base, iov[i].iov_len))
+            force_exit(-1);
+    }
+}
+
+/* Reads from FILE into the IOVCNT buffers in IOV, or writes them
+   to FILE if WRITE is true, starting at file position POS and
+   going straight to the inode.  Returns the number of bytes
+   transferred, which falls short only at end of file or when
+   the file cannot be written. */
+static int
+file_transfer_at(struct file *file, const struct iovec *iov, int iovcnt,
+                 off_t pos, bool write)
+{
+    int total = 0;
+    int i;
+
+    for(i = 0; i < iovcnt; i++)
+    {
+        off_t size = iov[i].iov_len;
+        off_t done = write
+                     ? file_write_at(file, iov[i].iov_base, size, pos + total)
+                     : file_read_at(file, iov[i].iov_base, size, pos + total);
+        total += done;
+        if(done < size)
+            break;
+    }
+    return total;
+}
+
+/* readv and writev transfer at the file's position and advance
+   it, like read and write.  They return -1 for a bad descriptor
+   or buffer count. */
+static void
+syscall_readv(struct argv *args, uint32_t *eax)
+{
+    int fd = (int)args->arg[0];
+    const struct iovec *uiov = (const struct iovec*)args->arg[1];
+    int iovcnt = (int)args->arg[2];
+    struct iovec iov[IOV_MAX];
+    struct file *file;
+    int bytes;
+
+    if(iovcnt < 0 || iovcnt > IOV_MAX)
+    {
+        *eax = -1;
+        return;
+    }
+    copy_iovec_from_user(iov, uiov, iovcnt, true);
+
+    file = get_file(fd);
+    if(!file)
+    {
+        *eax = -1;
+        return;
+    }
+    bytes = file_transfer_at(file, iov, iovcnt, file_tell(file), false);
+    file_seek(file, file_tell(file) + bytes);
+    *eax = bytes;
+}
+
+static void
+syscall_writev(struct argv *args, uint32_t *eax)
+{
+    int fd = (int)args->arg[0];
+    const struct iovec *uiov = (const struct iovec*)args->arg[1];
+    int iovcnt = (int)args->arg[2];
+    struct iovec iov[IOV_MAX];
+    struct file *file;
+    int bytes;
+
+    if(iovcnt < 0 || iovcnt > IOV_MAX)
+    {
+        *eax = -1;
+        return;
+    }
+    copy_iovec_from_user(iov, uiov, iovcnt, false);
+
+    if(fd == STDOUT_FILENO)
+    {
+        int i;
+        for(bytes = 0, i = 0; i < iovcnt; i++)
+        {
+            putbuf(iov[i].iov_base, iov[i].iov_len);
+            bytes += iov[i].iov_len;
+        }
+        *eax = bytes;
+        return;
+    }
+
+    file = get_file(fd);
+    if(!file)
+    {
+        *eax = -1;
+        return;
+    }
+    bytes = file_transfer_at(file, iov, iovcnt, file_tell(file), true);
+    file_seek(file, file_tell(file) + bytes);
+    *eax = bytes;
+}
+
+/* pread and pwrite transfer at the given position and leave the
+   file's own position alone, so processes sharing a file need
+   not seek first.  They return -1 for a bad descriptor. */
+static void
+syscall_pread(struct argv *args, uint32_t *eax)
+{
+    int fd = (int)args->arg[0];
+    struct iovec iov;
+    off_t pos = (off_t)args->arg[3];
+    struct file *file;
+
+    iov.iov_base = args->arg[1];
+    iov.iov_len = (size_t)args->arg[2];
+    if(!iov.iov_base
+    || !is_writable_user_buffer(iov.iov_base, iov.iov_len))
+        force_exit(-1);
+
+    file = get_file(fd);
+    if(!file || pos < 0)
+        *eax = -1;
+    else
+        *eax = file_transfer_at(file, &iov, 1, pos, false);
+}
+
+static void
+syscall_pwrite(struct argv *args, uint32_t *eax)
+{
+    int fd = (int)args->arg[0];
+    struct iovec iov;
+    off_t pos = (off_t)args->arg[3];
+    struct file *file;
+
+    iov.iov_base = args->arg[1];
+    iov.iov_len = (size_t)args->arg[2];
+    if(!iov.iov_base
+    || !is_valid_user_buffer(iov.iov_base, iov.iov_len))
+        force_exit(-1);
+
+    file = get_file(fd);
+    if(!file || pos < 0)
+        *eax = -1;
+    else
+        *eax = file_transfer_at(file, &iov, 1, pos, true);
+}
+
+/* Registers the system call ring at user address RING for the
+   current process, replacing any earlier one.  See lib/ring.h. */
+static void
+syscall_ring_setup(struct argv *args, uint32_t *eax)
+{
+    struct ring *ring = (struct ring*)args->arg[0];
+
+    if(!ring
+    || !is_writable_user_buffer(ring, sizeof *ring))
+        force_exit(-1);
+
+    thread_current()->proc->ring = ring;
+    *eax = true;
+}
+
+/* Carries out the requests queued in the current process's
+   system call ring, posting a completion for each, and returns
+   how many were carried out, or -1 if there is no ring.  The
+   ring is checked once per batch; after that its entries are
+   read and written in place. */
+static void
+syscall_ring_enter(struct argv *args, uint32_t *eax)
+{
+    struct ring *ring = thread_current()->proc->ring;
+    unsigned sq_tail;
+    int done = 0;
+
+    if(!ring)
+    {
+        *eax = -1;
+        return;
+    }
+    if(!is_writable_user_buffer(ring, sizeof *ring))
+        force_exit(-1);
+
+    sq_tail = ring->sq_tail;
+    while(ring->sq_head != sq_tail
+          && ring->cq_tail - ring->cq_head < RING_ENTRIES)
+    {
+        struct ring_sqe *sqe = &ring->sq[ring->sq_head % RING_ENTRIES];
+        struct ring_cqe *cqe = &ring->cq[ring->cq_tail % RING_ENTRIES];
+        int op = sqe->opcode;
+        uint32_t result = -1;
+
+        if(op >= SYS_HALT
+        && op < (int)(sizeof syscall_tbl / sizeof *syscall_tbl)
+        && syscall_tbl[op].fn
+        && op != SYS_FORK && op != SYS_RING_SETUP && op != SYS_RING_ENTER)
+        {
+            struct argv sargs;
+            memcpy(sargs.arg, sqe->args, sizeof sargs.arg);
+            sargs.frame = args->frame;
+            result = 0;
+            syscall_tbl[op].fn(&sargs, &result);
+        }
+
+        cqe->user_data = sqe->user_data;
+        cqe->result = result;
+        ring->cq_tail++;
+        ring->sq_head++;
+        done++;
+    }
+    *eax = done;
+}
+
+/* Copies up to SIZE bytes from the file open as IN_FD, starting
+   at its position, to the file open as OUT_FD or to the console,
+   without passing them through user memory.  Advances the
+   positions of both files and returns the number of bytes
+   copied, which falls short at the end of the input file or when
+   the output file cannot be written, or -1 for a bad descriptor. */
+static void
+syscall_sendfile(struct argv *args, uint32_t *eax)
+{
+    int out_fd = (int)args->arg[0];
+    int in_fd = (int)args->arg[1];
+    unsigned size = (unsigned)args->arg[2];
+    struct file *in, *out = NULL;
+    unsigned total = 0;
+    void *page;
+
+    in = get_file(in_fd);
+    if(out_fd != STDOUT_FILENO)
+        out = get_file(out_fd);
+    if(!in || (out_fd != STDOUT_FILENO && !out))
+    {
+        *eax = -1;
+        return;
+    }
+
+    page = palloc_get_page(0);
+    if(!page)
+    {
+        *eax = -1;
+        return;
+    }
+
+    while(total < size)
+    {
+        off_t chunk = size - total < PGSIZE ? size - total : PGSIZE;
+        off_t bytes = file_read(in, page, chunk);
+        off_t written = bytes;
+
+        if(out)
+            written = file_write(out, page, bytes);
+        else
+            putbuf(page, bytes);
+        total += written;
+        if(written < bytes)
+        {
+            /* Leave IN just past the bytes that made it out. */
+            file_seek(in, file_tell(in) - (bytes - written));
+            break;
+        }
+        if(bytes < chunk)
+            break;
+    }
+    palloc_free_page(page);
+    *eax = total;
+}
+
+/* Like exec, but takes the arguments as the null-terminated
+   array ARGV instead of a command line to split at spaces, so
+   arguments may contain spaces.  ARGV[0] names the program.  With
+   SPAWN_INHERIT_FDS in FLAGS, the child starts with its own
+   handle on each of our open files, under the same descriptor. */
+static void
+syscall_spawn(struct argv *args, uint32_t *eax)
+{
+    char *const *uargv = (char *const*)args->arg[0];
+    int flags = (int)args->arg[1];
+    struct process_args *pargs;
+    int i;
+
+    pargs = process_args_create();
+    if(!pargs)
+    {
+        *eax = TID_ERROR;
+        return;
+    }
+
+    for(i = 0; ; i++)
+    {
+        const char *uarg;
+        size_t room;
+        char *dst;
+        int len;
+
+        if(!copy_from_user(&uarg, &uargv[i], sizeof uarg))
+        {
+            process_args_destroy(pargs);
+            force_exit(-1);
+        }
+        if(!uarg)
+            break;
+
+        dst = process_args_next(pargs, &room);
+        len = dst ? strncpy_from_user(dst, uarg, room) : 0;
+        if(len < 0)
+        {
+            process_args_destroy(pargs);
+            force_exit(-1);
+        }
+        if(!dst || (size_t)len >= room)
+        {
+            process_args_destroy(pargs);
+            *eax = TID_ERROR;
+            return;
+        }
+        process_args_add(pargs, len);
+    }
+
+    if(i == 0)
+    {
+        process_args_destroy(pargs);
+        *eax = TID_ERROR;
+        return;
+    }
+    *eax = process_spawn(pargs, (flags & SPAWN_INHERIT_FDS) != 0);
+}
+
+/* Reaps any child that has exited, without waiting for the
+   others, and stores its exit status at user address STATUS
+   unless that is null.  Waits up to TIMEOUT milliseconds for one
+   to exit, indefinitely if TIMEOUT is negative.  Returns the
+   child's pid, 0 if none exited in time, or -1 if there are no
+   children left to wait for. */
+static void
+syscall_waitany(struct argv *args, uint32_t *eax)
+{
+    int *ustatus = (int*)args->arg[0];
+    int timeout = (int)args->arg[1];
+    int64_t ticks = -1;
+    int status;
+    tid_t tid;
+
+    if(ustatus && !is_writable_user_buffer(ustatus, sizeof *ustatus))
+        force_exit(-1);
+
+    if(timeout >= 0)
+        ticks = ((int64_t)timeout * TIMER_FREQ + 999) / 1000;
+    tid = process_wait_any(&status, ticks);
+    if(tid > 0 && ustatus && !copy_to_user(ustatus, &status, sizeof status))
+        force_exit(-1);
+    *eax = tid;
+}
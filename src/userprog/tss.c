@@ -75,6 +75,25 @@ struct tss
 /* Kernel TSS. */
 static struct tss *tss;
 
+/* SYSENTER loads its stack pointer from a model-specific
+   register instead of the TSS, so when it is enabled that
+   register has to follow esp0.  See [IA32-v3a] 4.8.7 "Performing
+   Fast Calls to System Procedures with the SYSENTER and SYSEXIT
+   Instructions". */
+#define MSR_SYSENTER_CS  0x174  /* Kernel code selector. */
+#define MSR_SYSENTER_ESP 0x175  /* Kernel stack pointer. */
+#define MSR_SYSENTER_EIP 0x176  /* Kernel entry point. */
+#define CPUID_SEP (1 << 11)     /* CPUID 1 EDX: SYSENTER present. */
+
+static bool sysenter_enabled;
+
+/* Writes VALUE to model-specific register MSR. */
+static inline void
+wrmsr (uint32_t msr, uint32_t value) 
+{
+  asm volatile ("wrmsr" : : "c" (msr), "a" (value), "d" (0));
+}
+
 /* Initializes the kernel TSS. */
 void
 tss_init (void) 
@@ -103,4 +122,33 @@ tss_update (void)
 {
   ASSERT (tss != NULL);
   tss->esp0 = (uint8_t *) thread_current () + PGSIZE;
+  if (sysenter_enabled)
+    wrmsr (MSR_SYSENTER_ESP, (uint32_t) tss->esp0);
+}
+
+/* Makes SYSENTER enter the kernel at ENTRY, on the same stack
+   as interrupts from user mode.  Returns false, leaving SYSENTER
+   disabled, if the CPU does not support it. */
+bool
+tss_enable_sysenter (void (*entry) (void)) 
+{
+  uint32_t eax, ebx, ecx, edx;
+  unsigned family, model, stepping;
+
+  asm ("cpuid" : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) : "a" (1));
+  family = (eax >> 8) & 0xf;
+  model = (eax >> 4) & 0xf;
+  stepping = eax & 0xf;
+
+  /* Early Pentium Pro processors report SEP but do not
+     implement SYSENTER. */
+  if ((edx & CPUID_SEP) == 0
+      || (family == 6 && model < 3 && stepping < 3))
+    return false;
+
+  wrmsr (MSR_SYSENTER_CS, SEL_KCSEG);
+  wrmsr (MSR_SYSENTER_EIP, (uint32_t) entry);
+  sysenter_enabled = true;
+  tss_update ();
+  return true;
 }
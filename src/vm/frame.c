@@ -0,0 +1,143 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include "threads/loader.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "vm/share.h"
+
+/* Frame table.
+
+   There is one entry for every physical page of RAM, indexed by
+   physical page number, although only pages handed out from the
+   user pool by frame_alloc() are ever used.  Each entry counts
+   the page directories that currently map the frame, so that a
+   frame may be mapped into several processes at once and is
+   returned to the page allocator only when the last mapping
+   goes away.
+
+   Frames that belong to the shared page cache (see share.c)
+   remember their cache entry, and their last reference is
+   dropped through the cache so that the entry is removed at the
+   same time. */
+
+/* A physical frame. */
+struct frame
+  {
+    unsigned ref_cnt;           /* Number of mappings of this frame. */
+    struct share *share;        /* Shared page cache entry, or null. */
+  };
+
+static struct frame *frames;    /* One entry per page of RAM. */
+static struct lock frame_lock;  /* Protects ref_cnt members. */
+
+static struct frame *frame_lookup (const void *kpage);
+
+/* Initializes the frame table. */
+void
+frame_init (void)
+{
+  size_t page_cnt = DIV_ROUND_UP (init_ram_pages * sizeof *frames, PGSIZE);
+
+  frames = palloc_get_multiple (PAL_ASSERT | PAL_ZERO, page_cnt);
+  lock_init (&frame_lock);
+}
+
+/* Obtains a page from the user pool, as palloc_get_page() with
+   PAL_USER added to FLAGS, and records a single reference to
+   it.  Returns the page's kernel virtual address, or a null
+   pointer if no page is available. */
+void *
+frame_alloc (enum palloc_flags flags)
+{
+  void *kpage = palloc_get_page (flags | PAL_USER);
+
+  if (kpage != NULL)
+    {
+      struct frame *f = frame_lookup (kpage);
+
+      ASSERT (f->ref_cnt == 0);
+      f->ref_cnt = 1;
+      f->share = NULL;
+    }
+  return kpage;
+}
+
+/* Adds a reference to KPAGE, which must already be in use. */
+void
+frame_ref (void *kpage)
+{
+  struct frame *f = frame_lookup (kpage);
+
+  lock_acquire (&frame_lock);
+  ASSERT (f->ref_cnt > 0);
+  f->ref_cnt++;
+  lock_release (&frame_lock);
+}
+
+/* Drops a reference to KPAGE and returns the number of
+   references that remain.  The frame is not freed; that is up
+   to the caller when the count reaches zero. */
+unsigned
+frame_unref (void *kpage)
+{
+  struct frame *f = frame_lookup (kpage);
+  unsigned ref_cnt;
+
+  lock_acquire (&frame_lock);
+  ASSERT (f->ref_cnt > 0);
+  ref_cnt = --f->ref_cnt;
+  lock_release (&frame_lock);
+  return ref_cnt;
+}
+
+/* Drops a reference to KPAGE, returning it to the page
+   allocator if that was the last one. */
+void
+frame_release (void *kpage)
+{
+  struct frame *f = frame_lookup (kpage);
+
+  /* A frame's cache entry is set before the frame is first
+     shared and never changes afterward, so it is safe to
+     examine without the lock. */
+  if (f->share != NULL)
+    share_release (f->share);
+  else if (frame_unref (kpage) == 0)
+    palloc_free_page (kpage);
+}
+
+/* Returns the number of references to KPAGE. */
+unsigned
+frame_ref_cnt (const void *kpage)
+{
+  return frame_lookup (kpage)->ref_cnt;
+}
+
+/* Associates KPAGE with shared page cache entry SHARE, or
+   dissociates it if SHARE is null. */
+void
+frame_set_share (void *kpage, struct share *share)
+{
+  frame_lookup (kpage)->share = share;
+}
+
+/* Returns the shared page cache entry for KPAGE, or a null
+   pointer if it is a private frame. */
+struct share *
+frame_get_share (const void *kpage)
+{
+  return frame_lookup (kpage)->share;
+}
+
+/* Returns the frame table entry for KPAGE. */
+static struct frame *
+frame_lookup (const void *kpage)
+{
+  uintptr_t paddr = vtop (kpage);
+
+  ASSERT (pg_ofs (kpage) == 0);
+  ASSERT (paddr >> PGBITS < init_ram_pages);
+  return &frames[paddr >> PGBITS];
+}
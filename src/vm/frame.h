@@ -0,0 +1,19 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <stdbool.h>
+#include "threads/palloc.h"
+
+struct share;
+
+void frame_init (void);
+void *frame_alloc (enum palloc_flags);
+void frame_ref (void *kpage);
+unsigned frame_unref (void *kpage);
+void frame_release (void *kpage);
+unsigned frame_ref_cnt (const void *kpage);
+
+void frame_set_share (void *kpage, struct share *);
+struct share *frame_get_share (const void *kpage);
+
+#endif /* vm/frame.h */
@@ -0,0 +1,447 @@
+#include "vm/page.h"
+#include <debug.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "filesys/inode.h"
+#include "userprog/pagedir.h"
+#include "vm/frame.h"
+#include "vm/share.h"
+
+/* Supplemental page table.
+
+   Each process keeps a table of the user pages that it owns but
+   that are not necessarily present in its page directory, so
+   that a page fault on one of them can be satisfied instead of
+   killing the process.
+
+   Pages that start out all zeros (BSS, mostly) are not given a
+   frame when the program is loaded.  The first read of such a
+   page maps a single frame of zeros, shared by every process,
+   read-only; only the first write allocates a private frame.  A
+   program that never touches most of a large BSS array thus
+   never pays for it.
+
+   Pages read from a file (an executable's text and data) are
+   likewise not read until they are touched.  Faulting them in
+   one at a time would make a sequential scan take a trap per
+   page, so a fault on one also maps the other not-yet-present
+   pages of the same file within an aligned window of
+   `fault_around' pages.  Read-only file pages come from the
+   shared page cache (see vm/share.c), so for those the
+   neighbors are often resident already.
+
+   A process created by fork shares all of its parent's frames
+   (see pagedir_clone()).  Writable pages are mapped read-only
+   and copy-on-write in both processes, and the first write to
+   one by either process gives that process a private copy.
+
+   The stack starts out as a single page and grows on demand: a
+   fault just below the user stack pointer adds a page of zeros,
+   up to STACK_MAX bytes in all. */
+
+/* Maximum size of a process's stack, in bytes. */
+#define STACK_MAX (8 * 1024 * 1024)
+
+/* Accesses up to this many bytes below the stack pointer are
+   allowed, for PUSHA. */
+#define STACK_SLOP 32
+
+/* The shared frame of zeros.  We hold a reference to it forever,
+   so it is never freed. */
+static void *zero_page;
+
+/* Number of pages, including the faulting one, that a fault on
+   a file page may map. */
+static size_t fault_around;
+
+static hash_hash_func page_hash;
+static hash_less_func page_less;
+static struct page *page_lookup (const void *upage);
+static bool page_break_cow (uint32_t *pd, void *upage);
+static bool page_load_file (uint32_t *pd, struct page *);
+static void page_fault_around (uint32_t *pd, void *upage, struct inode *);
+static bool page_is_stack (const void *uaddr);
+static void page_destroy (struct hash_elem *, void *aux);
+
+/* Initializes the page module.  A fault on a file page will
+   map up to FAULT_AROUND pages at once. */
+void
+page_init (size_t fault_around_)
+{
+  fault_around = fault_around_ > 0 ? fault_around_ : 1;
+  zero_page = frame_alloc (PAL_ASSERT | PAL_ZERO);
+}
+
+/* Creates an empty supplemental page table for the running
+   thread.  Returns true if successful, false on memory
+   allocation failure.  The table resizes incrementally, so that
+   a page fault that happens to grow it is not much slower than
+   any other. */
+bool
+page_table_init (void)
+{
+  struct thread *t = thread_current ();
+
+  ASSERT (t->pages == NULL);
+  t->pages = malloc (sizeof *t->pages);
+  if (t->pages == NULL)
+    return false;
+  if (!hash_init_incremental (t->pages, page_hash, page_less, NULL))
+    {
+      free (t->pages);
+      t->pages = NULL;
+      return false;
+    }
+  return true;
+}
+
+/* Destroys the running thread's supplemental page table, if it
+   has one.  The frames that its pages occupy are owned by the
+   page directory and freed along with it. */
+void
+page_table_destroy (void)
+{
+  struct thread *t = thread_current ();
+
+  if (t->pages != NULL)
+    {
+      hash_destroy (t->pages, page_destroy);
+      free (t->pages);
+      t->pages = NULL;
+    }
+}
+
+/* Creates a supplemental page table for the running thread that
+   duplicates SRC, the table of the process it was forked from.
+   Returns true if successful, false on memory allocation
+   failure. */
+bool
+page_table_copy (struct hash *src)
+{
+  struct hash_iterator i;
+
+  if (!page_table_init ())
+    return false;
+
+  hash_first (&i, src);
+  while (hash_next (&i))
+    {
+      struct page *p = hash_entry (hash_cur (&i), struct page, elem);
+      struct page *copy = malloc (sizeof *copy);
+      if (copy == NULL)
+        return false;
+      *copy = *p;
+      if (copy->type == PAGE_FILE)
+        inode_reopen (copy->inode);
+      hash_insert (thread_current ()->pages, &copy->elem);
+    }
+  return true;
+}
+
+/* Adds UPAGE to the running thread's address space as a page of
+   zeros, writable if WRITABLE is true.  No frame is allocated
+   until the page is touched.  Returns false if UPAGE is already
+   in the table or on memory allocation failure. */
+bool
+page_add_zero (void *upage, bool writable)
+{
+  struct page *p;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (is_user_vaddr (upage));
+
+  p = malloc (sizeof *p);
+  if (p == NULL)
+    return false;
+  p->upage = upage;
+  p->type = PAGE_ZERO;
+  p->writable = writable;
+  if (hash_insert (thread_current ()->pages, &p->elem) != NULL)
+    {
+      free (p);
+      return false;
+    }
+  return true;
+}
+
+/* Adds UPAGE to the running thread's address space as a page
+   whose first READ_BYTES bytes are to be read from INODE at
+   offset OFS, the rest zeroed, writable if WRITABLE is true.
+   Nothing is read until the page is touched.  Returns false if
+   UPAGE is already in the table or on memory allocation
+   failure. */
+bool
+page_add_file (void *upage, struct inode *inode, off_t ofs,
+               size_t read_bytes, bool writable)
+{
+  struct page *p;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (is_user_vaddr (upage));
+  ASSERT (ofs % PGSIZE == 0);
+  ASSERT (read_bytes > 0 && read_bytes <= PGSIZE);
+
+  p = malloc (sizeof *p);
+  if (p == NULL)
+    return false;
+  p->upage = upage;
+  p->type = PAGE_FILE;
+  p->writable = writable;
+  p->inode = inode;
+  p->ofs = ofs;
+  p->read_bytes = read_bytes;
+  if (hash_insert (thread_current ()->pages, &p->elem) != NULL)
+    {
+      free (p);
+      return false;
+    }
+  inode_reopen (inode);
+  return true;
+}
+
+/* Attempts to resolve a page fault at user address FAULT_ADDR
+   in the running thread.  NOT_PRESENT and WRITE describe the
+   fault as in the page fault error code.  Returns true if the
+   faulting access may now be retried, storing the kind of fault
+   into *TYPE, or false if it is a genuine violation. */
+bool
+page_fault_in (void *fault_addr, bool not_present, bool write,
+               enum page_fault_type *type)
+{
+  uint32_t *pd = thread_current ()->pagedir;
+  void *upage = pg_round_down (fault_addr);
+  struct page *p;
+  void *kpage;
+
+  if (pd == NULL || !is_user_vaddr (fault_addr))
+    return false;
+  if (write && !not_present && pagedir_is_cow (pd, upage))
+    {
+      *type = FAULT_COW;
+      return page_break_cow (pd, upage);
+    }
+
+  p = page_lookup (upage);
+  *type = FAULT_ZERO;
+  if (p == NULL && not_present && page_is_stack (fault_addr))
+    {
+      /* Grow the stack by a page of zeros. */
+      if (!page_add_zero (upage, true))
+        return false;
+      p = page_lookup (upage);
+      *type = FAULT_STACK;
+    }
+  if (p == NULL || (write && !p->writable))
+    return false;
+
+  switch (p->type)
+    {
+    case PAGE_ZERO:
+      if (!write)
+        {
+          /* First read: map the shared zero frame read-only. */
+          if (!not_present)
+            return false;
+          frame_ref (zero_page);
+          if (!pagedir_set_page (pd, p->upage, zero_page, false))
+            {
+              frame_release (zero_page);
+              return false;
+            }
+          return true;
+        }
+
+      /* First write: replace the zero frame, if it is mapped,
+         with a private frame of zeros. */
+      kpage = frame_alloc (PAL_ZERO);
+      if (kpage == NULL)
+        return false;
+      if (!not_present)
+        {
+          ASSERT (pagedir_get_page (pd, p->upage) == zero_page);
+          pagedir_clear_page (pd, p->upage);
+          frame_release (zero_page);
+        }
+      if (!pagedir_set_page (pd, p->upage, kpage, true))
+        {
+          frame_release (kpage);
+          return false;
+        }
+      p->type = PAGE_FRAME;
+      return true;
+
+    case PAGE_FILE:
+      {
+        struct inode *inode = p->inode;
+
+        *type = FAULT_FILE;
+        inode_reopen (inode);
+        if (page_load_file (pd, p))
+          page_fault_around (pd, p->upage, inode);
+        inode_close (inode);
+        return p->type == PAGE_FRAME;
+      }
+
+    case PAGE_FRAME:
+    default:
+      return false;
+    }
+}
+
+/* Reads file page P into a frame and maps it in PD.  Returns
+   true if successful, false on memory allocation failure or a
+   short read. */
+static bool
+page_load_file (uint32_t *pd, struct page *p)
+{
+  uint8_t *kpage;
+
+  ASSERT (p->type == PAGE_FILE);
+
+  if (!p->writable)
+    kpage = share_get_page (p->inode, p->ofs, p->read_bytes);
+  else
+    {
+      kpage = frame_alloc (0);
+      if (kpage != NULL
+          && inode_read_at (p->inode, kpage, p->read_bytes, p->ofs)
+             != (off_t) p->read_bytes)
+        {
+          frame_release (kpage);
+          kpage = NULL;
+        }
+      if (kpage != NULL)
+        memset (kpage + p->read_bytes, 0, PGSIZE - p->read_bytes);
+    }
+  if (kpage == NULL)
+    return false;
+
+  if (!pagedir_set_page (pd, p->upage, kpage, p->writable))
+    {
+      frame_release (kpage);
+      return false;
+    }
+  inode_close (p->inode);
+  p->type = PAGE_FRAME;
+  return true;
+}
+
+/* Having just faulted in UPAGE from INODE, maps the other pages
+   of INODE in the aligned window of `fault_around' pages around
+   it that are not yet present.  Failures are ignored: those
+   pages will simply fault on their own later. */
+static void
+page_fault_around (uint32_t *pd, void *upage_, struct inode *inode)
+{
+  uintptr_t first = pg_no (upage_) / fault_around * fault_around;
+  uintptr_t pg;
+
+  for (pg = first; pg < first + fault_around; pg++)
+    {
+      void *upage = (void *) (pg << PGBITS);
+      struct page *q;
+
+      if (!is_user_vaddr (upage))
+        break;
+      q = page_lookup (upage);
+      if (q != NULL && q->type == PAGE_FILE && q->inode == inode
+          && !page_load_file (pd, q))
+        break;
+    }
+}
+
+/* Gives the running thread a private, writable copy of UPAGE,
+   which is mapped copy-on-write in PD.  If no other process
+   still maps the frame, it is simply made writable.  Returns
+   true if successful, false on memory allocation failure. */
+static bool
+page_break_cow (uint32_t *pd, void *upage)
+{
+  void *old = pagedir_get_page (pd, upage);
+  void *kpage;
+
+  if (frame_ref_cnt (old) == 1 && frame_get_share (old) == NULL)
+    kpage = old;
+  else
+    {
+      kpage = frame_alloc (0);
+      if (kpage == NULL)
+        return false;
+      memcpy (kpage, old, PGSIZE);
+    }
+
+  /* UPAGE's page table already exists, so remapping it cannot
+     fail. */
+  pagedir_clear_page (pd, upage);
+  if (!pagedir_set_page (pd, upage, kpage, true))
+    NOT_REACHED ();
+  if (kpage != old)
+    frame_release (old);
+  return true;
+}
+
+/* Returns true if user address UADDR is where the running
+   thread's stack may grow to.  The user stack pointer is in the
+   interrupt frame at the top of the thread's kernel stack, saved
+   there on entry to the kernel whether by system call or by
+   fault. */
+static bool
+page_is_stack (const void *uaddr)
+{
+  const struct intr_frame *f
+    = (struct intr_frame *) ((uint8_t *) thread_current () + PGSIZE) - 1;
+  const uint8_t *addr = uaddr;
+
+  return addr >= (uint8_t *) PHYS_BASE - STACK_MAX
+         && is_user_vaddr (addr)
+         && addr + STACK_SLOP >= (uint8_t *) f->esp;
+}
+
+/* Returns the page containing UPAGE in the running thread's
+   supplemental page table, or a null pointer if there is
+   none. */
+static struct page *
+page_lookup (const void *upage)
+{
+  struct thread *t = thread_current ();
+  struct page key;
+  struct hash_elem *e;
+
+  if (t->pages == NULL)
+    return NULL;
+  key.upage = (void *) upage;
+  e = hash_find (t->pages, &key.elem);
+  return e != NULL ? hash_entry (e, struct page, elem) : NULL;
+}
+
+/* Returns a hash value for the page in E. */
+static unsigned
+page_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct page *p = hash_entry (e, struct page, elem);
+  return hash_int ((uintptr_t) p->upage >> PGBITS);
+}
+
+/* Returns true if page A precedes page B. */
+static bool
+page_less (const struct hash_elem *a_, const struct hash_elem *b_,
+           void *aux UNUSED)
+{
+  const struct page *a = hash_entry (a_, struct page, elem);
+  const struct page *b = hash_entry (b_, struct page, elem);
+  return a->upage < b->upage;
+}
+
+/* Frees the page in E. */
+static void
+page_destroy (struct hash_elem *e, void *aux UNUSED)
+{
+  struct page *p = hash_entry (e, struct page, elem);
+
+  if (p->type == PAGE_FILE)
+    inode_close (p->inode);
+  free (p);
+}
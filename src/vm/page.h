@@ -0,0 +1,52 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <hash.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "filesys/off_t.h"
+
+/* Where a page's contents come from. */
+enum page_type
+  {
+    PAGE_ZERO,                  /* All zeros, not yet written. */
+    PAGE_FILE,                  /* To be read from a file. */
+    PAGE_FRAME                  /* Resident in a private frame. */
+  };
+
+/* A page of user virtual memory. */
+struct page
+  {
+    struct hash_elem elem;      /* Element in thread's page table. */
+    void *upage;                /* User virtual address. */
+    enum page_type type;        /* Current backing. */
+    bool writable;              /* May the process write the page? */
+
+    /* PAGE_FILE only. */
+    struct inode *inode;        /* File to read from. */
+    off_t ofs;                  /* Offset of the page in INODE. */
+    size_t read_bytes;          /* Bytes to read; the rest are zero. */
+  };
+
+/* Kinds of page fault that page_fault_in() resolves. */
+enum page_fault_type
+  {
+    FAULT_ZERO,                 /* Zero-filled page. */
+    FAULT_FILE,                 /* Page read from a file. */
+    FAULT_STACK,                /* New stack page. */
+    FAULT_COW,                  /* Copy of a copy-on-write page. */
+    FAULT_TYPE_CNT              /* Number of fault types. */
+  };
+
+void page_init (size_t fault_around);
+bool page_table_init (void);
+void page_table_destroy (void);
+bool page_table_copy (struct hash *src);
+
+bool page_add_zero (void *upage, bool writable);
+bool page_add_file (void *upage, struct inode *, off_t ofs,
+                    size_t read_bytes, bool writable);
+bool page_fault_in (void *fault_addr, bool not_present, bool write,
+                    enum page_fault_type *);
+
+#endif /* vm/page.h */
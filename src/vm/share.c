@@ -0,0 +1,152 @@
+#include "vm/share.h"
+#include <debug.h>
+#include <hash.h>
+#include <string.h>
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "vm/frame.h"
+
+/* Shared page cache.
+
+   Read-only pages loaded from an executable are identical in
+   every process that runs it, so instead of giving each process
+   its own copy we keep one frame per distinct page and map it
+   into every page directory that needs it.  A page is
+   identified by the inode it was read from, its offset within
+   that inode, and the number of bytes read (the rest of the
+   page is zero), so that two segments that happen to start at
+   the same file page but read different amounts never share.
+
+   An executable cannot be written while a process is running
+   it (see file_deny_write()), so a cached page cannot go stale
+   while it is mapped.  When the last mapping of a page goes
+   away the page leaves the cache, so nothing is cached for a
+   file that nobody is running. */
+
+/* A shared page. */
+struct share
+  {
+    struct hash_elem elem;      /* Element in `shares'. */
+    block_sector_t inumber;     /* Inode the page was read from. */
+    off_t ofs;                  /* Offset of the page in the inode. */
+    size_t read_bytes;          /* Bytes read; the rest are zero. */
+    void *kpage;                /* The frame. */
+  };
+
+static struct hash shares;      /* Cached pages. */
+static struct lock share_lock;  /* Protects `shares'. */
+
+static hash_hash_func share_hash;
+static hash_less_func share_less;
+
+/* Initializes the shared page cache. */
+void
+share_init (void)
+{
+  hash_init (&shares, share_hash, share_less, NULL);
+  lock_init (&share_lock);
+}
+
+/* Returns a frame holding the page at offset OFS in INODE, with
+   READ_BYTES bytes read from INODE and the rest of the page
+   zeroed.  If another process already has that page mapped,
+   returns the same frame; otherwise reads it and adds it to the
+   cache.  Either way the caller receives a reference to the
+   frame, which it must drop with frame_release().  Returns a
+   null pointer if memory cannot be allocated or the read
+   fails. */
+void *
+share_get_page (struct inode *inode, off_t ofs, size_t read_bytes)
+{
+  struct share key, *s;
+  struct hash_elem *e;
+  void *kpage = NULL;
+
+  ASSERT (ofs % PGSIZE == 0);
+  ASSERT (read_bytes <= PGSIZE);
+
+  key.inumber = inode_get_inumber (inode);
+  key.ofs = ofs;
+  key.read_bytes = read_bytes;
+
+  lock_acquire (&share_lock);
+  e = hash_find (&shares, &key.elem);
+  if (e != NULL)
+    {
+      s = hash_entry (e, struct share, elem);
+      kpage = s->kpage;
+      frame_ref (kpage);
+    }
+  else
+    {
+      s = malloc (sizeof *s);
+      if (s != NULL)
+        kpage = frame_alloc (0);
+      if (kpage != NULL
+          && inode_read_at (inode, kpage, read_bytes, ofs) == (off_t) read_bytes)
+        {
+          memset ((uint8_t *) kpage + read_bytes, 0, PGSIZE - read_bytes);
+          *s = key;
+          s->kpage = kpage;
+          hash_insert (&shares, &s->elem);
+          frame_set_share (kpage, s);
+        }
+      else
+        {
+          if (kpage != NULL)
+            frame_release (kpage);
+          free (s);
+          kpage = NULL;
+        }
+    }
+  lock_release (&share_lock);
+
+  return kpage;
+}
+
+/* Drops a reference to the frame in S.  If it was the last one,
+   removes S from the cache and frees the frame. */
+void
+share_release (struct share *s)
+{
+  lock_acquire (&share_lock);
+  if (frame_unref (s->kpage) == 0)
+    {
+      hash_delete (&shares, &s->elem);
+      frame_set_share (s->kpage, NULL);
+      palloc_free_page (s->kpage);
+      free (s);
+    }
+  lock_release (&share_lock);
+}
+
+/* Returns a hash value for the page in E. */
+static unsigned
+share_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct share *s = hash_entry (e, struct share, elem);
+  unsigned key[3];
+
+  key[0] = s->inumber;
+  key[1] = s->ofs;
+  key[2] = s->read_bytes;
+  return hash_bytes (key, sizeof key);
+}
+
+/* Orders shared pages by inode, then offset, then size. */
+static bool
+share_less (const struct hash_elem *a_, const struct hash_elem *b_,
+            void *aux UNUSED)
+{
+  const struct share *a = hash_entry (a_, struct share, elem);
+  const struct share *b = hash_entry (b_, struct share, elem);
+
+  if (a->inumber != b->inumber)
+    return a->inumber < b->inumber;
+  else if (a->ofs != b->ofs)
+    return a->ofs < b->ofs;
+  else
+    return a->read_bytes < b->read_bytes;
+}
@@ -0,0 +1,14 @@
+#ifndef VM_SHARE_H
+#define VM_SHARE_H
+
+#include <stddef.h>
+#include "filesys/off_t.h"
+
+struct inode;
+struct share;
+
+void share_init (void);
+void *share_get_page (struct inode *, off_t ofs, size_t read_bytes);
+void share_release (struct share *);
+
+#endif /* vm/share.h */